@@ -0,0 +1,43 @@
+#include <chrono>
+#include <thread>
+
+#include "detector/async_face_detector.h"
+#include "platform/emscripten_compat.h"
+#include "sample_jpg.h"
+
+// Headless check of the off-main-thread detector.
+// Frames are submitted faster than they can be processed, so some of them are expected to drop.
+EMSCRIPTEN_KEEPALIVE
+int main() {
+  std::vector<unsigned char> sample_image(elon_jpg, elon_jpg + elon_jpg_len);
+  auto image = cv::imdecode(sample_image, cv::IMREAD_COLOR);
+  cv::cvtColor(image, image, cv::COLOR_BGR2RGBA);
+
+  vc::AsyncFaceDetector detector;
+  detector.Start();
+
+  vc::FaceResult result;
+  int received = 0;
+  for (auto i = 0 ; i < 100 ; i ++) {
+    detector.Submit(image.data, image.cols, image.rows);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    if (detector.Poll(result)) ++received;
+  }
+
+  // Let the last frame finish
+  while (detector.GetStats().processed + detector.GetStats().dropped < 100)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  if (detector.Poll(result)) ++received;
+  detector.Stop();
+
+  auto stats = detector.GetStats();
+  printf("Submitted : %llu, Processed : %llu, Dropped : %llu, Received : %d\n",
+         static_cast<unsigned long long>(stats.submitted),
+         static_cast<unsigned long long>(stats.processed),
+         static_cast<unsigned long long>(stats.dropped),
+         received);
+  printf("Last result : frame=%llu found=%d angle=%f\n",
+         static_cast<unsigned long long>(result.frame_id), result.found, result.angle);
+
+  return stats.processed + stats.dropped == stats.submitted ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#include <chrono>
+
+#include "concurrent/task_pool.h"
+#include "detector/batch_face_detector.h"
+#include "platform/emscripten_compat.h"
+#include "sample_jpg.h"
+
+// Images per second of BatchFaceDetector for 1..PTHREAD_POOL_SIZE workers
+EMSCRIPTEN_KEEPALIVE
+int main() {
+  // Lanes beyond the caller run on the task pool, give it the rest of the pthread pool
+  vc::TaskPool::Configure(PTHREAD_POOL_SIZE - 1);
+
+  std::vector<unsigned char> sample_image(elon_jpg, elon_jpg + elon_jpg_len);
+  auto image = cv::imdecode(sample_image, cv::IMREAD_COLOR);
+
+  const int batch_size = 64;
+  std::vector<vc::ImageDesc> images(batch_size, vc::ImageDesc::Packed(vc::PixelFormat::kBGR, image.data,
+                                                                      image.cols, image.rows,
+                                                                      static_cast<int>(image.step)));
+  std::vector<vc::FaceResult> results(batch_size);
+
+  using namespace std::chrono;
+  for (int num_workers = 1; num_workers <= PTHREAD_POOL_SIZE; ++num_workers) {
+    vc::BatchFaceDetector detector(num_workers);
+
+    // warm up
+    detector.Detect(images.data(), num_workers, results.data());
+
+    auto start_time = high_resolution_clock::now();
+    detector.Detect(images.data(), batch_size, results.data());
+    auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count() / 1e9;
+
+    int found = 0;
+    for (const auto& result : results) found += result.found;
+    printf("Workers : %d, Images/sec : %f, Found : %d/%d\n", num_workers, batch_size / elapsed, found, batch_size);
+  }
+
+  return 0;
+}
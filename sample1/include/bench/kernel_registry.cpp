@@ -0,0 +1,17 @@
+#include "bench/kernel_registry.h"
+
+namespace vc {
+namespace bench {
+
+KernelRegistry& KernelRegistry::Instance() {
+  static KernelRegistry registry;
+  return registry;
+}
+
+bool KernelRegistry::Register(KernelEntry entry) {
+  entries.push_back(std::move(entry));
+  return true;
+}
+
+} // namespace bench
+} // namespace vc
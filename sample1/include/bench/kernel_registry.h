@@ -0,0 +1,60 @@
+#ifndef WASMSAMPLE_BENCH_KERNEL_REGISTRY_H_
+#define WASMSAMPLE_BENCH_KERNEL_REGISTRY_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+namespace vc {
+namespace bench {
+
+// Preprocessing primitives of BlazeFaceWrapper and main.cpp, applied to a whole frame
+constexpr const char* kCvtColorRGBA2RGB = "cvtColor_RGBA2RGB";
+constexpr const char* kResize = "resize";                  // letterbox resize to 128 px wide
+constexpr const char* kCopyMakeBorder = "copyMakeBorder";  // constant border to a square
+constexpr const char* kWarpAffine = "warpAffine";          // 30 degree rotation, same size
+constexpr const char* kConvertTo = "convertTo";            // 8-bit to normalized float
+
+// One timed call. pixels is the destination pixel count, the unit of ns per pixel.
+struct KernelRun {
+  std::function<void()> run;
+  size_t pixels = 0;
+};
+
+// Builds a run of the primitive for an RGBA frame, allocating its inputs and outputs up front
+using KernelFactory = std::function<KernelRun(const cv::Mat& rgba)>;
+
+struct KernelEntry {
+  std::string primitive;
+  std::string implementation;
+  KernelFactory factory;
+  bool threaded = false;  // also timed with cv::setNumThreads(PTHREAD_POOL_SIZE)
+};
+
+// Kernels register themselves from their own translation unit with VC_REGISTER_KERNEL, so a
+// candidate only needs a source file added to the benchmark target.
+class KernelRegistry {
+ public:
+  static KernelRegistry& Instance();
+
+  bool Register(KernelEntry entry);
+  const std::vector<KernelEntry>& Entries() const { return entries; }
+
+ private:
+  std::vector<KernelEntry> entries;
+};
+
+#define VC_KERNEL_CONCAT_(a, b) a##b
+#define VC_KERNEL_CONCAT(a, b) VC_KERNEL_CONCAT_(a, b)
+
+// VC_REGISTER_KERNEL(vc::bench::kResize, "lite", factory[, threaded])
+#define VC_REGISTER_KERNEL(primitive, implementation, ...)                     \
+  static const bool VC_KERNEL_CONCAT(kernel_registered_, __LINE__) =           \
+      ::vc::bench::KernelRegistry::Instance().Register({primitive, implementation, __VA_ARGS__})
+
+} // namespace bench
+} // namespace vc
+
+#endif //WASMSAMPLE_BENCH_KERNEL_REGISTRY_H_
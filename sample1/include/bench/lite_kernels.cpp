@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "bench/kernel_registry.h"
+#include "image/lite_imgproc.h"
+
+namespace vc {
+namespace bench {
+namespace {
+
+// The frames come from OpenCV, the lite kernels get views of the same pixels
+lite::Mat LiteView(const cv::Mat& mat) {
+  return lite::Mat(mat.rows, mat.cols, lite::MakeType(mat.depth(), mat.channels()), mat.data, mat.step);
+}
+
+lite::Mat ToRGB(const cv::Mat& rgba) {
+  lite::Mat rgb;
+  lite::cvtColor(LiteView(rgba), rgb, lite::COLOR_RGBA2RGB);
+  return rgb;
+}
+
+VC_REGISTER_KERNEL(kCvtColorRGBA2RGB, "lite", [](const cv::Mat& rgba) {
+  auto src = LiteView(rgba);
+  lite::Mat dst;
+  return KernelRun{[src, dst]() mutable { lite::cvtColor(src, dst, lite::COLOR_RGBA2RGB); }, rgba.total()};
+});
+
+VC_REGISTER_KERNEL(kResize, "lite", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  lite::Size size(128, std::max(1, 128 * src.rows / src.cols));
+  lite::Mat dst;
+  return KernelRun{[src, dst, size]() mutable { lite::resize(src, dst, size); },
+                   static_cast<size_t>(size.width) * size.height};
+});
+
+VC_REGISTER_KERNEL(kCopyMakeBorder, "lite", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  auto side = std::max(src.cols, src.rows);
+  auto left = (side - src.cols) / 2, top = (side - src.rows) / 2;
+  lite::Mat dst;
+  return KernelRun{[src, dst, side, left, top]() mutable {
+    lite::copyMakeBorder(src, dst, top, side - src.rows - top, left, side - src.cols - left,
+                         lite::BORDER_CONSTANT, {0, 0, 0});
+  }, static_cast<size_t>(side) * side};
+});
+
+VC_REGISTER_KERNEL(kWarpAffine, "lite", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  auto m = lite::getRotationMatrix2D(lite::Point2f(src.cols / 2.f, src.rows / 2.f), 30, 1);
+  lite::Mat dst;
+  return KernelRun{[src, dst, m]() mutable { lite::warpAffine(src, dst, m, src.size()); }, src.total()};
+});
+
+VC_REGISTER_KERNEL(kConvertTo, "lite", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  lite::Mat dst;
+  return KernelRun{[src, dst]() mutable { src.convertTo(dst, lite::kDepth32F, 1 / 127.5f, -1); }, src.total()};
+});
+
+} // namespace
+} // namespace bench
+} // namespace vc
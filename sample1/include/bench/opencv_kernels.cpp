@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "bench/kernel_registry.h"
+
+namespace vc {
+namespace bench {
+namespace {
+
+cv::Mat ToRGB(const cv::Mat& rgba) {
+  cv::Mat rgb;
+  cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
+  return rgb;
+}
+
+VC_REGISTER_KERNEL(kCvtColorRGBA2RGB, "opencv", [](const cv::Mat& rgba) {
+  cv::Mat dst;
+  return KernelRun{[rgba, dst]() mutable { cv::cvtColor(rgba, dst, cv::COLOR_RGBA2RGB); }, rgba.total()};
+}, true);
+
+VC_REGISTER_KERNEL(kResize, "opencv", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  cv::Size size(128, std::max(1, 128 * src.rows / src.cols));
+  cv::Mat dst;
+  return KernelRun{[src, dst, size]() mutable { cv::resize(src, dst, size); },
+                   static_cast<size_t>(size.area())};
+}, true);
+
+VC_REGISTER_KERNEL(kCopyMakeBorder, "opencv", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  auto side = std::max(src.cols, src.rows);
+  auto left = (side - src.cols) / 2, top = (side - src.rows) / 2;
+  cv::Mat dst;
+  return KernelRun{[src, dst, side, left, top]() mutable {
+    cv::copyMakeBorder(src, dst, top, side - src.rows - top, left, side - src.cols - left,
+                       cv::BORDER_CONSTANT, {0, 0, 0});
+  }, static_cast<size_t>(side) * side};
+}, true);
+
+VC_REGISTER_KERNEL(kWarpAffine, "opencv", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  auto m = cv::getRotationMatrix2D(cv::Point2f(src.cols / 2.f, src.rows / 2.f), 30, 1);
+  cv::Mat dst;
+  return KernelRun{[src, dst, m]() mutable { cv::warpAffine(src, dst, m, src.size()); }, src.total()};
+}, true);
+
+VC_REGISTER_KERNEL(kConvertTo, "opencv", [](const cv::Mat& rgba) {
+  auto src = ToRGB(rgba);
+  cv::Mat dst;
+  return KernelRun{[src, dst]() mutable { src.convertTo(dst, CV_32F, 1 / 127.5f, -1); }, src.total()};
+}, true);
+
+} // namespace
+} // namespace bench
+} // namespace vc
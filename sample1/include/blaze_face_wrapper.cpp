@@ -1,39 +1,269 @@
 #include "blaze_face_wrapper.h"
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
 #include <tuple>
 #include <utility>
 
-#include "opencv2/opencv.hpp"
-
+#include "concurrent/task_pool.h"
 #include "model/model_reader.h"
 #include "vccc/log.hpp"
 #include "vccc/math.hpp"
 
 namespace vc {
 
-BlazeFaceWrapper::BlazeFaceWrapper() {
-  auto model_data = vc::ModelReader::ReadBlazeFaceModel();
-  cute::CuteModelBuilder builder({{model_data.byte, model_data.size, 2, false}});
+namespace {
+
+// Searched by the recovery batch, in this order: upright, a quarter turn either way, upside down
+constexpr double kPi = vccc::math_constant::pi<double>;
+constexpr std::array<Angle, 4> kRecoveryAngles{0, kPi / 2, -kPi / 2, kPi};
+
+// Row bands SampleInput splits the input tensor into on the task pool
+constexpr int kSampleBands = 4;
+
+} // namespace
+
+BlazeFaceWrapper::BlazeFaceWrapper()
+  : BlazeFaceWrapper(2) {}
+
+BlazeFaceWrapper::BlazeFaceWrapper(int num_threads)
+  : BlazeFaceWrapper(vc::ModelReader::ReadBlazeFaceModel(), num_threads) {}
+
+BlazeFaceWrapper::BlazeFaceWrapper(const ModelReader::ModelData& model_data, int num_threads)
+  : BlazeFaceWrapper(model_data.byte, model_data.size, num_threads) {}
+
+BlazeFaceWrapper::BlazeFaceWrapper(const void* model_buffer, size_t model_size, int num_threads, bool raw_input)
+  : model_buffer(model_buffer), model_size(model_size), num_threads(num_threads),
+    input_scale(raw_input ? 1.f : BlazeFaceShortRange::kInputScale),
+    input_offset(raw_input ? 0.f : BlazeFaceShortRange::kInputOffset) {
+  auto start_time = NowMs();
+  cute::CuteModelBuilder builder({{model_buffer, model_size, num_threads, false}});
   BuildModel(builder);
-};
+  cold_start.build_ms = NowMs() - start_time;
+}
 
 //
 // Module API
 //
 Result BlazeFaceWrapper::Execute(const Image &input, Angle prior_angle) {
+  auto face = Detect(input, prior_angle);
+  return {face.roi, face.angle};
+}
+
+Result BlazeFaceWrapper::Execute(const ImageDesc& input, Angle prior_angle) {
+  auto face = Detect(input, prior_angle);
+  return {face.roi, face.angle};
+}
+
+FaceDetection BlazeFaceWrapper::Detect(const Image& input, Angle prior_angle) {
   // Return VoidOutput if no image is passed
   if (input.empty()) {
-    return {ROI(), 0};
+    return {};
   }
 
-  auto [face_roi, face_score, face_landmarks] = Run(input, prior_angle);
+  if (SkipByInterval())
+    return ReuseLastFace(0);
+
+  auto searching = recovery_enabled && !recovery_suspended && !tracking;
+  auto detection = searching ? Recover(input) : Run(input, prior_angle);
+  tracking = !std::get<0>(detection).empty();
+  stats.Record(stage_times, !std::get<0>(detection).empty(), std::get<1>(detection));
+  auto face = MakeFaceDetection(std::move(detection));
+  FinishInference(face);
+  return face;
+}
+
+FaceDetection BlazeFaceWrapper::Detect(const ImageDesc& input, Angle prior_angle) {
+  if (input.empty()) {
+    return {};
+  }
+
+  if (SkipByInterval())
+    return ReuseLastFace(0);
+
+  double gate_ms = 0;
+  if (change_gate_enabled) {
+    auto start_time = NowMs();
+    auto unchanged = change_detector.Unchanged(input);
+    gate_ms = NowMs() - start_time;
+    if (unchanged)
+      return ReuseLastFace(gate_ms);
+  }
+
+  auto searching = recovery_enabled && !recovery_suspended && !tracking;
+  auto detection = searching ? Recover(input) : Run(input, prior_angle);
+  tracking = !std::get<0>(detection).empty();
+  stage_times[Stage::kChangeGate] = gate_ms;
+  stats.Record(stage_times, !std::get<0>(detection).empty(), std::get<1>(detection));
+  auto face = MakeFaceDetection(std::move(detection));
+
+  if (change_gate_enabled)
+    change_detector.SetReference(input, face.roi);
+  FinishInference(face);
+  return face;
+}
+
+// Runs the model unless the QoS interval says this frame reuses the last result
+bool BlazeFaceWrapper::SkipByInterval() {
+  return qos != nullptr && has_last_face && ++frames_since_inference < qos->Point().interval;
+}
+
+// The last inferred result again, for a frame that did not run the model
+FaceDetection BlazeFaceWrapper::ReuseLastFace(double gate_ms) {
+  stage_times.clear();
+  stage_times[Stage::kChangeGate] = gate_ms;
+  stats.Record(stage_times, !last_face.roi.empty(), last_face.score, true);
+  UpdateQos();
+
+  auto face = last_face;
+  face.reused = true;
+  return face;
+}
+
+void BlazeFaceWrapper::FinishInference(const FaceDetection& face) {
+  // The frame paid the one-time setup, a later Warmup has nothing left to do
+  warmed_up = true;
+  last_face = face;
+  has_last_face = true;
+  frames_since_inference = 0;
+  UpdateQos();
+}
+
+void BlazeFaceWrapper::UpdateQos() {
+  if (qos != nullptr && qos->Update(stage_times.total()))
+    ApplyQosPoint();
+}
+
+void BlazeFaceWrapper::ApplyQosPoint() {
+  const auto& point = qos->Point();
+  if (point.num_threads != num_threads)
+    SetNumThreads(point.num_threads);
+  recovery_suspended = !point.recovery;
+}
+
+// Only a found face is reported, with the angle its landmarks give
+FaceDetection BlazeFaceWrapper::MakeFaceDetection(Detection detection) {
+  auto& [face_roi, face_score, face_landmarks] = detection;
   if (face_roi.empty()) {
-    return {ROI(), 0};
+    return {};
   }
 
   auto rotation_result = CalculateFaceAngleFromLandmarks(face_landmarks);
-  return {face_roi, rotation_result};
+  return {std::move(face_roi), face_score, std::move(face_landmarks), rotation_result};
+}
+
+void BlazeFaceWrapper::EnableRecovery(bool enable) {
+  recovery_enabled = enable;
+  tracking = false;
+  if (!enable || recovery_model.isBuilt())
+    return;
+
+  // The model keeps batch 1 in its reshapes, so a batch of N is N times as many anchors per output
+  recovery_model.loadBuffer(model_buffer, model_size)
+                .shareCpuBackend(model)
+                .setNumThreads(num_threads)
+                .setInputDims(0, {static_cast<int>(kRecoveryAngles.size()), target_size[0], target_size[1], 3})
+                .build();
+  assert(((void)"Recovery batch does not match the model geometry",
+          recovery_model.outputBytes(c_index) == kRecoveryAngles.size() * Decoder::kNumAnchors * sizeof(float)));
+  // The main interpreter was rebuilt onto the shared backend
+  warmed_up = false;
+}
+
+void BlazeFaceWrapper::EnableChangeGate(bool enable, float threshold) {
+  change_gate_enabled = enable;
+  change_detector.SetThreshold(threshold);
+  change_detector.Reset();
+}
+
+void BlazeFaceWrapper::SetQos(const QosOptions& options) {
+  recovery_suspended = false;
+  if (options.target_ms <= 0) {
+    qos.reset();
+    return;
+  }
+  // The ladder stays within the threads the task pool leaves in the pthread pool
+  auto capped = options;
+  capped.max_threads = std::min(options.max_threads > 0 ? options.max_threads : num_threads,
+                                TaskPool::MaxInterpreterThreads());
+  qos = std::make_unique<QosController>(capped, num_threads, recovery_enabled);
+  ApplyQosPoint();
+}
+
+QosReport BlazeFaceWrapper::QosStatus() const {
+  return qos != nullptr ? qos->Report() : QosReport();
+}
+
+void BlazeFaceWrapper::Warmup() {
+  if (warmed_up)
+    return;
+  warmed_up = true;
+
+  auto start_time = NowMs();
+  std::fill_n(static_cast<float*>(model.inputData(0)), target_size[0] * target_size[1] * 3, 0.f);
+  model.invoke();
+  cold_start.warmup_ms = NowMs() - start_time;
+  LOGD("Blaze Face : build ", cold_start.build_ms, "ms, warmup ", cold_start.warmup_ms, "ms");
+}
+
+const ColdStartTimes& BlazeFaceWrapper::ColdStart() const {
+  return cold_start;
+}
+
+void BlazeFaceWrapper::SetNumThreads(int num_threads) {
+  auto start_time = NowMs();
+  this->num_threads = num_threads;
+  model.setNumThreads(num_threads);
+  model.build();
+  if (recovery_model.isBuilt()) {
+    recovery_model.setNumThreads(num_threads);
+    recovery_model.build();
+  }
+  cold_start.build_ms = NowMs() - start_time;
+  warmed_up = false;
+}
+
+void BlazeFaceWrapper::EnableOpTracing(bool enable) {
+  op_trace_starts.clear();
+  if (!enable) {
+    model.setOpEventCallback(nullptr);
+    return;
+  }
+  model.setOpEventCallback([this](const char* tag, bool begin) {
+    if (begin) {
+      op_trace_starts.push_back(NowMs());
+    } else if (!op_trace_starts.empty()) {
+      auto start = op_trace_starts.back();
+      op_trace_starts.pop_back();
+      TraceRecorder::Instance().Record(tag, "op", start, NowMs());
+    }
+  });
+}
+
+ThreadTuning BlazeFaceWrapper::TuneThreads(const ThreadTuneOptions& options) {
+  auto model_data = vc::ModelReader::ReadBlazeFaceModel();
+  return ThreadTuner::Tune(model_data.byte, model_data.size, options);
+}
+
+const StageTimes& BlazeFaceWrapper::LastStageTimes() const {
+  return stage_times;
+}
+
+DetectorStats BlazeFaceWrapper::SnapshotStats(bool reset) {
+  return stats.Snapshot(reset);
+}
+
+MemoryReport BlazeFaceWrapper::MemoryUsage() const {
+  MemoryReport report;
+  report.model_bytes = model.modelBytes();
+  report.arena_bytes = model.arenaBytes() + recovery_model.arenaBytes();
+  report.persistent_arena_bytes = model.persistentArenaBytes() + recovery_model.persistentArenaBytes();
+  report.image_scratch_bytes = image_scratch_bytes;
+  report.budget_bytes = MemoryBudget::Instance().Cap();
+  report.heap = HeapStats::Read();
+  return report;
 }
 
 //
@@ -44,154 +274,268 @@ void BlazeFaceWrapper::BuildModel(const cute::CuteModelBuilder& builder) {
 
   LOGD(">>> Init blaze-face: \n", model.summarize());
 
-  auto dims = model.inputTensorDims(0);
-  target_size = std::vector{dims[1], dims[2]};
-
   for (int i = 0; i < model.outputTensorCount(); ++i) {
     const auto& tensor = model.outputTensor(i);
     if (cute::tensorName(tensor) == "regressors") r_index = i;
     if (cute::tensorName(tensor) == "classificators") c_index = i;
   }
 
+  [[maybe_unused]] auto dims = model.inputTensorDims(0);
+  assert(((void)"Model geometry does not match BlazeFaceShortRange",
+          Decoder::Matches(dims[2], dims[1], model.outputBytes(r_index) / sizeof(float),
+                           model.outputBytes(c_index) / sizeof(float))));
+
   InitOptions();
-  InitAnchors();
 }
 
 Detection BlazeFaceWrapper::Run(const Image& image, Angle prior_angle) {
+  stage_times.clear();
+
   auto _image = PreProcess(image, prior_angle);
 
-  model.setInput(_image.data);
-  model.invoke();
+  {
+    ScopedStage timer(stage_times, Stage::kInvoke);
+    model.setInput(_image.data);
+    model.invoke();
+  }
+
+  ScopedStage timer(stage_times, Stage::kPostProcess);
+  return PostProcess(prior_angle);
+}
+
+Detection BlazeFaceWrapper::Run(const ImageDesc& image, Angle prior_angle) {
+  stage_times.clear();
+
+  PreProcess(image, prior_angle);
+
+  {
+    ScopedStage timer(stage_times, Stage::kInvoke);
+    model.invoke();
+  }
 
+  ScopedStage timer(stage_times, Stage::kPostProcess);
   return PostProcess(prior_angle);
 }
 
+// One batched invoke over kRecoveryAngles instead of one invoke per angle
+Detection BlazeFaceWrapper::Recover(const Image& image) {
+  stage_times.clear();
+
+  Image resized_image;
+  {
+    ScopedStage timer(stage_times, Stage::kResize);
+    resized_image = ResizeImage(image);
+  }
+
+  auto* dst = static_cast<float*>(recovery_model.inputData(0));
+  const auto plane = static_cast<size_t>(target_size[0]) * target_size[1] * 3;
+  for (size_t i = 0; i < kRecoveryAngles.size(); ++i) {
+    Image aligned_image;
+    {
+      ScopedStage timer(stage_times, Stage::kAlign);
+      aligned_image = AlignImage(resized_image, kRecoveryAngles[i], target_size);
+    }
+    ScopedStage timer(stage_times, Stage::kNormalize);
+    auto normalized_image = NormalizeImage(aligned_image, input_scale, input_offset);
+    std::copy_n(reinterpret_cast<const float*>(normalized_image.data), plane, dst + i * plane);
+  }
+
+  {
+    ScopedStage timer(stage_times, Stage::kInvoke);
+    recovery_model.invoke();
+  }
+
+  ScopedStage timer(stage_times, Stage::kPostProcess);
+  return PostProcessRecovery();
+}
+
+Detection BlazeFaceWrapper::Recover(const ImageDesc& image) {
+  stage_times.clear();
+
+  {
+    ScopedStage timer(stage_times, Stage::kSample);
+    letterbox = ComputeLetterbox(image.width, image.height);
+    auto* dst = static_cast<float*>(recovery_model.inputData(0));
+    const auto plane = static_cast<size_t>(target_size[0]) * target_size[1] * 3;
+    const auto count = static_cast<int>(kRecoveryAngles.size());
+    TaskPool::Instance().ParallelFor(count, count, [&](int i, int) {
+      SampleInput(image, letterbox, kRecoveryAngles[i], dst + i * plane);
+    });
+  }
+
+  {
+    ScopedStage timer(stage_times, Stage::kInvoke);
+    recovery_model.invoke();
+  }
+
+  ScopedStage timer(stage_times, Stage::kPostProcess);
+  return PostProcessRecovery();
+}
+
+// The best-scoring angle of the batch, mapped back to the frame by the angle it was searched at
+Detection BlazeFaceWrapper::PostProcessRecovery() const {
+  auto raw_boxes = recovery_model.getOutput<float>(r_index);
+  auto scores = recovery_model.getOutput<float>(c_index);
+  const auto batch_size = static_cast<int>(kRecoveryAngles.size());
+  auto batch_major = recovery_model.outputTensorDims(c_index)[0] == batch_size;
+
+  Floats item_boxes(Decoder::kNumAnchors * Decoder::kBoxSize), item_scores(Decoder::kNumAnchors);
+  Detection best{ROI(), -1, Points()};
+  for (int i = 0; i < batch_size; ++i) {
+    Decoder::Unbatch(raw_boxes.data(), batch_size, i, Decoder::kBoxSize, batch_major, item_boxes.data());
+    Decoder::Unbatch(scores.data(), batch_size, i, 1, batch_major, item_scores.data());
+    auto detection = PostProcess(item_boxes.data(), item_scores.data(), item_scores.size(), letterbox,
+                                 kRecoveryAngles[i]);
+    if (std::get<1>(detection) > std::get<1>(best))
+      best = std::move(detection);
+  }
+  return best;
+}
+
 Image BlazeFaceWrapper::PreProcess(const Image &image, Angle prior_angle) {
-  auto resized_image = ResizeImage(image);
-  auto aligned_image = AlignImage(resized_image, prior_angle, target_size);
-  return NormalizeImage(aligned_image);
+  Image resized_image, aligned_image;
+  {
+    ScopedStage timer(stage_times, Stage::kResize);
+    resized_image = ResizeImage(image);
+  }
+  {
+    ScopedStage timer(stage_times, Stage::kAlign);
+    aligned_image = AlignImage(resized_image, prior_angle, target_size);
+  }
+  ScopedStage timer(stage_times, Stage::kNormalize);
+  auto normalized_image = NormalizeImage(aligned_image, input_scale, input_offset);
+
+  // Live at the same time; the ImageDesc path needs none of them
+  auto bytes = [](const Image& mat) { return mat.total() * mat.elemSize(); };
+  image_scratch_bytes = std::max(image_scratch_bytes,
+                                 bytes(resized_image) + bytes(aligned_image) + bytes(normalized_image));
+  return normalized_image;
+}
+
+// Same geometry as ResizeImage -> AlignImage -> NormalizeImage, sampled straight into the input tensor
+void BlazeFaceWrapper::PreProcess(const ImageDesc& image, Angle prior_angle) {
+  ScopedStage timer(stage_times, Stage::kSample);
+  letterbox = ComputeLetterbox(image.width, image.height);
+  SampleInput(image, letterbox, prior_angle, static_cast<float*>(model.inputData(0)));
+}
+
+void BlazeFaceWrapper::SampleInput(const ImageDesc& image, const Letterbox& box, Angle prior_angle, float* dst) const {
+  auto map = ModelToImageMap(box, image.width, image.height, prior_angle);
+  const auto rows = target_size[0];
+  TaskPool::Instance().ParallelFor(kSampleBands, kSampleBands, [&](int band, int) {
+    SampleRGBRows(image, map, dst, target_size[1], rows * band / kSampleBands, rows * (band + 1) / kSampleBands,
+                  input_scale, input_offset);
+  });
 }
 
 Detection BlazeFaceWrapper::PostProcess(Angle prior_angle) {
+  auto raw_boxes = model.getOutput<float>(r_index);
+  auto scores = model.getOutput<float>(c_index);
+  return PostProcess(raw_boxes.data(), scores.data(), scores.size(), letterbox, prior_angle);
+}
+
+Detection BlazeFaceWrapper::PostProcess(const float* raw_boxes, const float* scores, size_t num_anchors,
+                                        const Letterbox& box, Angle prior_angle) const {
   static const auto sigmoid_custom = [](auto x) {
     using value_type = decltype(x);
     return static_cast<value_type>(1. / (1. + std::exp(-x)));
   };
 
-  auto raw_boxes = model.getOutput<float>(r_index);
-  auto scores = model.getOutput<float>(c_index);
-  auto max_index = std::max_element(scores.cbegin(), scores.cend()) - scores.cbegin();
-
+  assert(num_anchors == static_cast<size_t>(Decoder::kNumAnchors));
+  auto max_index = Decoder::ArgMax(scores);
   auto score = static_cast<Score>(sigmoid_custom(scores[max_index]));
-  Floats raw_box(raw_boxes.begin() + 16 * max_index, raw_boxes.begin() + 16 * (max_index + 1));
-  cv::Point2f anchor = anchors[max_index];
 
   if (score < threshold) {
     LOGD("Blaze Face : Score under threshold: score=", score);
-    return Detection{ROI(), 0, Points()};
+    return Detection{ROI(), score, Points()};
   }
 
+  auto decoded = Decoder::Decode(raw_boxes, max_index);
+  Floats froi(decoded.box.begin(), decoded.box.end());
+  Points points;
+  points.reserve(decoded.keypoints.size());
+  for (const auto& keypoint : decoded.keypoints)
+    points.emplace_back(keypoint.x, keypoint.y);
 
-  auto [froi, points] = DecodeBox(raw_box, anchor);
-  auto [iroi, points_aligned] = RealignOutputs(froi, points, prior_angle);
+  auto [iroi, points_aligned] = RealignOutputs(froi, points, box, prior_angle);
 
   return {iroi, score, points_aligned};
 }
 
 
 void BlazeFaceWrapper::InitOptions() {
-  scale = 128.0;
   threshold = 0.40;
-  num_keypoints = 6;
-  keypoint_coord_offset = 4;
-}
-
-void BlazeFaceWrapper::InitAnchors() {
-  double anchor_offset = 0.5, aspect_ratio = 1.0;
-  int input_width = target_size[1], input_height = target_size[0];
-
-  std::vector<int> strides = {8, 16, 16, 16};
-  min_scale = 0.1484375;
-  num_strides = static_cast<int>(strides.size());
-
-  std::vector<cv::Point2f> anchors_;
-  int layer_id = 0;
-  while (layer_id < num_strides) {
-    auto last_same_stride_layer = layer_id;
-
-    int processing_number = 0;
-    while (last_same_stride_layer < strides.size()
-    && strides[last_same_stride_layer] == strides[layer_id]) {
-      processing_number += 2;
-      last_same_stride_layer += 1;
-    }
-
-    auto stride = strides[layer_id];
-    auto feature_map_height = static_cast<int>(input_height / stride);
-    auto feature_map_width = static_cast<int>(input_width / stride);
-
-    for (int y = 0; y < feature_map_height; ++y) {
-      for (int x = 0; x < feature_map_width; ++x) {
-        auto x_center =
-            static_cast<float>(x + anchor_offset) / feature_map_width;
-        auto y_center =
-            static_cast<float>(y + anchor_offset) / feature_map_height;
-        anchors_.insert(anchors_.end(),
-                        processing_number,
-                        {x_center, y_center});
-      }
-    }
-    layer_id = last_same_stride_layer;
-  } // end of while loop
-
-  anchors = std::move(anchors_);
 }
 
 //
 // Function
 //
 
-cv::Mat BlazeFaceWrapper::NormalizeImage(const Image& image) {
-  cv::Mat img;
-  image.convertTo(img, CV_32F, 1 / 127.5f, -1);
+Image BlazeFaceWrapper::NormalizeImage(const Image& image, float scale, float offset) {
+  Image img;
+  image.convertTo(img, CV_32F, scale, offset);
   return img;
 }
 
-Image BlazeFaceWrapper::ResizeImage(const Image& image) {
+Letterbox BlazeFaceWrapper::ComputeLetterbox(int image_width, int image_height) const {
   auto target_ratio = static_cast<double>(target_size[1]) / target_size[0];
-  auto input_ratio = static_cast<double>(image.size[1]) / image.size[0];
+  auto input_ratio = static_cast<double>(image_width) / image_height;
 
-  int target_width;
-  int target_height;
+  Letterbox box;
   if (input_ratio >= target_ratio) {
-    target_width = target_size[1];
-    target_height = static_cast<int>(target_width / input_ratio);
-    resize_ratio = static_cast<double>(target_width) / image.size[1];
+    box.width = target_size[1];
+    box.height = static_cast<int>(box.width / input_ratio);
+    box.resize_ratio = static_cast<double>(box.width) / image_width;
   } else {
-    target_height = target_size[0];
-    target_width = static_cast<int>(target_height * input_ratio);
-    resize_ratio = static_cast<double>(target_height) / image.size[0];
+    box.height = target_size[0];
+    box.width = static_cast<int>(box.height * input_ratio);
+    box.resize_ratio = static_cast<double>(box.height) / image_height;
   }
 
+  int width_diff = target_size[1] - box.width;
+  int height_diff = target_size[0] - box.height;
+  box.pad_left = ((0 > width_diff) ? 0 : width_diff) / 2;
+  box.pad_top = ((0 > height_diff) ? 0 : height_diff) / 2;
+  box.rotation_anchor = {target_size[1] / 2.0, target_size[0] / 2.0};
+  return box;
+}
+
+AffineMap BlazeFaceWrapper::ModelToImageMap(const Letterbox& letterbox, int image_width, int image_height, Angle angle) {
+  // Inverse of the rotation done by AlignImage (cv::getRotationMatrix2D around rotation_anchor)
+  auto c = std::cos(angle), s = std::sin(angle);
+  auto cx = letterbox.rotation_anchor[0], cy = letterbox.rotation_anchor[1];
+
+  // Letterboxed pixel -> image pixel, pixel centers aligned like cv::resize
+  auto sx = static_cast<double>(letterbox.width) / image_width;
+  auto sy = static_cast<double>(letterbox.height) / image_height;
+
+  AffineMap map;
+  map.m[0] = static_cast<float>(c / sx);
+  map.m[1] = static_cast<float>(-s / sx);
+  map.m[2] = static_cast<float>((-c * cx + s * cy + cx - letterbox.pad_left + 0.5) / sx - 0.5);
+  map.m[3] = static_cast<float>(s / sy);
+  map.m[4] = static_cast<float>(c / sy);
+  map.m[5] = static_cast<float>((-s * cx - c * cy + cy - letterbox.pad_top + 0.5) / sy - 0.5);
+  return map;
+}
+
+Image BlazeFaceWrapper::ResizeImage(const Image& image) {
+  letterbox = ComputeLetterbox(image.cols, image.rows);
+
   Image resized_image;
-  cv::resize(image, resized_image, {target_width, target_height});
-
-  int width_diff = target_size[1] - target_width;
-  int height_diff = target_size[0] - target_height;
-  pad_left = ((0 > width_diff) ? 0 : width_diff) / 2;
-  pad_top = ((0 > height_diff) ? 0 : height_diff) / 2;
-  auto pad_right = pad_left;
-  auto pad_bottom = pad_top;
-  pad_right += (width_diff % 2);
-  pad_bottom += (height_diff % 2);
-  rotation_anchor = {target_size[1] / 2.0, target_size[0] / 2.0};
-  cv::copyMakeBorder(resized_image,
+  cvx::resize(image, resized_image, {letterbox.width, letterbox.height});
+
+  int width_diff = target_size[1] - letterbox.width;
+  int height_diff = target_size[0] - letterbox.height;
+  auto pad_right = letterbox.pad_left + (width_diff % 2);
+  auto pad_bottom = letterbox.pad_top + (height_diff % 2);
+  cvx::copyMakeBorder(resized_image,
                      resized_image,
-                     pad_top,
+                     letterbox.pad_top,
                      pad_bottom,
-                     pad_left,
+                     letterbox.pad_left,
                      pad_right,
-                     cv::BORDER_CONSTANT,
+                     cvx::BORDER_CONSTANT,
                      {0, 0, 0});
   return resized_image;
 }
@@ -203,12 +547,12 @@ Image BlazeFaceWrapper::AlignImage(const Image& image,
   Points src_points;
   Points dst_points;
 
-  cv::Mat modified;
-  cv::Point2f pt;
+  Image modified;
+  Point pt;
 
   if (roi.empty()) {
     // Blaze
-    pt = cv::Point2f(static_cast<float>(dst_size[1] / 2.0), static_cast<float>(dst_size[0] / 2.0));
+    pt = Point(static_cast<float>(dst_size[1] / 2.0), static_cast<float>(dst_size[0] / 2.0));
     modified = image;
 
   } else {
@@ -216,8 +560,8 @@ Image BlazeFaceWrapper::AlignImage(const Image& image,
     auto target_height = roi[3] - roi[1];
 
     // Create rect representing the image
-    auto image_rect = cv::Rect({}, image.size());
-    auto cropped_roi = cv::Rect(roi[0], roi[1], target_width, target_height);
+    auto image_rect = cvx::Rect({}, image.size());
+    auto cropped_roi = cvx::Rect(roi[0], roi[1], target_width, target_height);
 
     // Find intersection, i.e. valid crop region
     auto intersection = image_rect & cropped_roi;
@@ -225,49 +569,25 @@ Image BlazeFaceWrapper::AlignImage(const Image& image,
     // Move intersection to the result coordinate space
     auto inter_roi = intersection - cropped_roi.tl();
 
-    modified = cv::Mat::zeros(cropped_roi.size(), image.type());
+    modified = Image::zeros(cropped_roi.size(), image.type());
     image(intersection).copyTo(modified(inter_roi));
 
-    pt = cv::Point2f(static_cast<float>(target_width / 2.), static_cast<float>(target_height / 2.));
+    pt = Point(static_cast<float>(target_width / 2.), static_cast<float>(target_height / 2.));
   }
 
-  cv::Mat r = cv::getRotationMatrix2D(pt, (angle * 180. / vccc::math_constant::pi<double>), 1.0);
+  Image r = cvx::getRotationMatrix2D(pt, (angle * 180. / vccc::math_constant::pi<double>), 1.0);
 
   // Rotate cropped image
-  cv::warpAffine(modified, modified, r, cv::Size(dst_size[1], dst_size[0]));
+  cvx::warpAffine(modified, modified, r, cvx::Size(dst_size[1], dst_size[0]));
 
   return modified;
 }
 
 
-FBox BlazeFaceWrapper::DecodeBox(const Floats& raw_box, const cv::Point2f& anchor) const {
-  auto x_center = raw_box[0], y_center = raw_box[1];
-  auto w = raw_box[2], h = raw_box[3];
-
-  x_center += static_cast<float>(anchor.x * scale);
-  y_center += static_cast<float>(anchor.y * scale);
-
-  float ymin = y_center - h / 2.f;
-  float xmin = x_center - w / 2.f;
-  float ymax = y_center + h / 2.f;
-  float xmax = x_center + w / 2.f;
-
-  auto roi = {xmin, ymin, xmax, ymax};
-  auto points = Points();
-
-  for (int i = 0; i < num_keypoints; ++i) {
-    auto offset = keypoint_coord_offset + i * 2;
-    auto keypoint_x = raw_box[offset], keypoint_y = raw_box[offset + 1];
-    points.emplace_back(static_cast<float>(keypoint_x + anchor.x * scale),
-                        static_cast<float>(keypoint_y + anchor.y * scale));
-  }
-
-  return {roi, std::move(points)};
-}
-
 Box BlazeFaceWrapper::RealignOutputs(Floats roi,
-                                                     const Points& points,
-                                                     Angle rotation) {
+                                     const Points& points,
+                                     const Letterbox& letterbox,
+                                     Angle rotation) const {
   roi = {roi[0], roi[1], roi[2], roi[3]};
 
   auto center_x = (roi[0] + roi[2]) / 2.f;
@@ -275,35 +595,35 @@ Box BlazeFaceWrapper::RealignOutputs(Floats roi,
   auto half_width = center_x - roi[0];
   auto half_height = center_y - roi[1];
 
-  auto x = center_x - rotation_anchor[0];
-  auto y = center_y - rotation_anchor[1];
+  auto x = center_x - letterbox.rotation_anchor[0];
+  auto y = center_y - letterbox.rotation_anchor[1];
   auto s = std::sin(rotation), c = std::cos(rotation);
 
   auto x_r = x * c - y * s;
   auto y_r = x * s + y * c;
 
-  auto new_center_x = static_cast<float>(x_r + rotation_anchor[0] - pad_left);
-  auto new_center_y = static_cast<float>(y_r + rotation_anchor[1] - pad_top);
+  auto new_center_x = static_cast<float>(x_r + letterbox.rotation_anchor[0] - letterbox.pad_left);
+  auto new_center_y = static_cast<float>(y_r + letterbox.rotation_anchor[1] - letterbox.pad_top);
 
   roi = {new_center_x - half_width, new_center_y - half_height,
          new_center_x + half_width, new_center_y + half_height};
 
   auto _roi = Ints();
   std::transform(roi.begin(), roi.end(), std::back_inserter(_roi),
-                 [this](float f) {
-    return static_cast<int>(std::round(f / resize_ratio));
+                 [&letterbox](float f) {
+    return static_cast<int>(std::round(f / letterbox.resize_ratio));
   });
 
   auto _points = Points();
   std::transform(points.begin(), points.end(), std::back_inserter(_points),
-                 [this, c, s](const auto& pt) {
-    auto x = pt.x - rotation_anchor[0];
-    auto y = pt.y - rotation_anchor[1];
+                 [&letterbox, c, s](const auto& pt) {
+    auto x = pt.x - letterbox.rotation_anchor[0];
+    auto y = pt.y - letterbox.rotation_anchor[1];
     auto x_r = x * c - y * s, y_r = x * s + y * c;
 
-    return cv::Point2f(
-        static_cast<float>((x_r + rotation_anchor[0] - pad_left) / resize_ratio),
-        static_cast<float>((y_r + rotation_anchor[1] - pad_top) / resize_ratio));
+    return Point(
+        static_cast<float>((x_r + letterbox.rotation_anchor[0] - letterbox.pad_left) / letterbox.resize_ratio),
+        static_cast<float>((y_r + letterbox.rotation_anchor[1] - letterbox.pad_top) / letterbox.resize_ratio));
   });
 
   return {_roi, _points};
@@ -0,0 +1,215 @@
+#include "capture/frame_stream.h"
+
+#include <cstring>
+
+#ifndef __EMSCRIPTEN__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+size_t PayloadBytes(PixelFormat format, int width, int height) {
+  size_t total = 0;
+  for (int i = 0; i < PlaneCount(format); ++i) {
+    auto size = GetPlaneSize(format, width, height, i);
+    total += static_cast<size_t>(size.row_bytes) * size.rows;
+  }
+  return total;
+}
+
+bool IsKnownFormat(int32_t format) {
+  return format >= static_cast<int32_t>(PixelFormat::kRGBA) && format <= static_cast<int32_t>(PixelFormat::kI420);
+}
+
+} // namespace
+
+//
+// FrameRecorder
+//
+FrameRecorder::~FrameRecorder() {
+  Close();
+}
+
+bool FrameRecorder::Open(const std::string& path) {
+  Close();
+  file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr)
+    return false;
+
+  FrameStreamHeader header;
+  frames = 0;
+  bytes = std::fwrite(&header, 1, sizeof(header), file);
+  return bytes == sizeof(header);
+}
+
+void FrameRecorder::Close() {
+  if (file == nullptr)
+    return;
+  std::fclose(file);
+  file = nullptr;
+}
+
+bool FrameRecorder::Record(const ImageDesc& image, double timestamp_ms) {
+  if (file == nullptr || image.empty())
+    return false;
+  if (frames == 0)
+    first_timestamp_ms = timestamp_ms;
+
+  auto packed = CopyImage(image, buffer);
+
+  FrameRecordHeader header;
+  header.format = static_cast<int32_t>(packed.format);
+  header.width = packed.width;
+  header.height = packed.height;
+  header.timestamp_ms = timestamp_ms - first_timestamp_ms;
+  header.payload_bytes = buffer.size();
+
+  if (std::fwrite(&header, 1, sizeof(header), file) != sizeof(header) ||
+      std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+    return false;
+
+  ++frames;
+  bytes += sizeof(header) + buffer.size();
+  return true;
+}
+
+//
+// FrameReplayer
+//
+FrameReplayer::~FrameReplayer() {
+  Close();
+}
+
+bool FrameReplayer::Open(const std::string& path) {
+  Close();
+
+#ifdef __EMSCRIPTEN__
+  auto* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    return false;
+  std::fseek(file, 0, SEEK_END);
+  file_buffer.resize(static_cast<size_t>(std::ftell(file)));
+  std::fseek(file, 0, SEEK_SET);
+  auto read = std::fread(file_buffer.data(), 1, file_buffer.size(), file);
+  std::fclose(file);
+  if (read != file_buffer.size())
+    return false;
+  data = file_buffer.data();
+  size = file_buffer.size();
+#else
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  mapping_size = static_cast<size_t>(st.st_size);
+  mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    return false;
+  }
+  // Frames are read front to back
+  ::madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+  data = static_cast<const unsigned char*>(mapping);
+  size = mapping_size;
+#endif
+
+  if (!Index()) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool FrameReplayer::Open(const unsigned char* data, size_t size) {
+  Close();
+  this->data = data;
+  this->size = size;
+  if (!Index()) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void FrameReplayer::Close() {
+#ifndef __EMSCRIPTEN__
+  if (mapping != nullptr)
+    ::munmap(mapping, mapping_size);
+#endif
+  mapping = nullptr;
+  mapping_size = 0;
+  file_buffer.clear();
+  file_buffer.shrink_to_fit();
+  data = nullptr;
+  size = 0;
+  offsets.clear();
+  next = 0;
+}
+
+double FrameReplayer::DurationMs() const {
+  return offsets.empty() ? 0 : FrameAt(FrameCount() - 1).timestamp_ms;
+}
+
+bool FrameReplayer::Next(ReplayFrame& frame) {
+  if (next >= FrameCount())
+    return false;
+  frame = FrameAt(next++);
+  return true;
+}
+
+bool FrameReplayer::Index() {
+  FrameStreamHeader expected, header;
+  if (size < sizeof(header))
+    return false;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version)
+    return false;
+
+  size_t offset = header.header_bytes;
+  FrameRecordHeader frame;
+  while (offset + sizeof(frame) <= size) {
+    std::memcpy(&frame, data + offset, sizeof(frame));
+    if (std::memcmp(frame.magic, FrameRecordHeader().magic, sizeof(frame.magic)) != 0 || !IsKnownFormat(frame.format)
+        || frame.width <= 0 || frame.height <= 0
+        || frame.payload_bytes != PayloadBytes(static_cast<PixelFormat>(frame.format), frame.width, frame.height)
+        || offset + sizeof(frame) + frame.payload_bytes > size)
+      break;
+    offsets.push_back(offset);
+    offset += sizeof(frame) + frame.payload_bytes;
+  }
+  return true;
+}
+
+ReplayFrame FrameReplayer::FrameAt(int index) const {
+  FrameRecordHeader header;
+  auto offset = offsets[index];
+  std::memcpy(&header, data + offset, sizeof(header));
+
+  ReplayFrame frame;
+  frame.index = index;
+  frame.timestamp_ms = header.timestamp_ms;
+  frame.image.format = static_cast<PixelFormat>(header.format);
+  frame.image.width = header.width;
+  frame.image.height = header.height;
+
+  const auto* plane = data + offset + sizeof(header);
+  for (int i = 0; i < PlaneCount(frame.image.format); ++i) {
+    auto plane_size = GetPlaneSize(frame.image.format, header.width, header.height, i);
+    frame.image.planes[i] = plane;
+    frame.image.strides[i] = plane_size.row_bytes;
+    plane += static_cast<size_t>(plane_size.row_bytes) * plane_size.rows;
+  }
+  return frame;
+}
+
+} // namespace vc
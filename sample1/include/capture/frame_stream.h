@@ -0,0 +1,116 @@
+#ifndef WASMSAMPLE_CAPTURE_FRAME_STREAM_H_
+#define WASMSAMPLE_CAPTURE_FRAME_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "image/image_desc.h"
+
+namespace vc {
+
+// Frame stream file (.vcfs), little-endian:
+//
+//   FrameStreamHeader
+//   per frame: FrameRecordHeader, then the planes of the frame tightly packed in plane order
+//              (CopyImage layout; an I420 payload is a Y4M frame without its "FRAME" line)
+//
+// Frames may change format and size within a stream.
+struct FrameStreamHeader {
+  char magic[4] = {'V', 'C', 'F', 'S'};
+  uint32_t version = 1;
+  uint32_t header_bytes = sizeof(FrameStreamHeader);
+  uint32_t frame_header_bytes = 32;
+};
+
+struct FrameRecordHeader {
+  char magic[4] = {'F', 'R', 'M', 'E'};
+  int32_t format = 0;         // PixelFormat
+  int32_t width = 0;
+  int32_t height = 0;
+  double timestamp_ms = 0;    // since the first frame of the stream
+  uint64_t payload_bytes = 0;
+};
+
+static_assert(sizeof(FrameStreamHeader) == 16, "FrameStreamHeader layout is part of the file format");
+static_assert(sizeof(FrameRecordHeader) == 32, "FrameRecordHeader layout is part of the file format");
+
+// Appends frames to a frame stream file. In wasm the file lives in the Emscripten file system
+// (MEMFS, read it back with FS.readFile).
+class FrameRecorder {
+ public:
+  FrameRecorder() = default;
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder&) = delete;
+  FrameRecorder& operator = (const FrameRecorder&) = delete;
+
+  // Truncates path
+  bool Open(const std::string& path);
+  void Close();
+  bool IsOpen() const { return file != nullptr; }
+
+  // timestamp_ms is any monotonic clock, it is stored relative to the first recorded frame
+  bool Record(const ImageDesc& image, double timestamp_ms);
+
+  int FrameCount() const { return frames; }
+  size_t Bytes() const { return bytes; }
+
+ private:
+  FILE* file = nullptr;
+  std::vector<unsigned char> buffer;
+  double first_timestamp_ms = 0;
+  int frames = 0;
+  size_t bytes = 0;
+};
+
+struct ReplayFrame {
+  ImageDesc image;
+  double timestamp_ms = 0;
+  int index = 0;
+};
+
+// Streams the frames of a frame stream without copying them.
+//
+// Open(path) memory-maps the file natively. In wasm it reads the file into memory; under node,
+// link with -s NODERAWFS=1 so that paths are those of the host file system.
+class FrameReplayer {
+ public:
+  FrameReplayer() = default;
+  ~FrameReplayer();
+
+  FrameReplayer(const FrameReplayer&) = delete;
+  FrameReplayer& operator = (const FrameReplayer&) = delete;
+
+  bool Open(const std::string& path);
+  // data must outlive the replayer
+  bool Open(const unsigned char* data, size_t size);
+  void Close();
+
+  // Frames of a stream that ends in a truncated frame stop before it
+  int FrameCount() const { return static_cast<int>(offsets.size()); }
+  double DurationMs() const;
+
+  // False after the last frame. frame.image points into the stream and is valid until Close().
+  bool Next(ReplayFrame& frame);
+  void Rewind() { next = 0; }
+
+ private:
+  bool Index();
+  ReplayFrame FrameAt(int index) const;
+
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+  std::vector<size_t> offsets;
+  int next = 0;
+
+  void* mapping = nullptr;
+  size_t mapping_size = 0;
+  std::vector<unsigned char> file_buffer;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_CAPTURE_FRAME_STREAM_H_
@@ -0,0 +1,113 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "concurrent/task_pool.h"
+#include "detector/tiled_face_detector.h"
+#include "image/jpeg_decoder.h"
+#include "profile/clock.h"
+#include "vccc/math.hpp"
+
+namespace {
+
+// Every face of each image at full resolution, see TiledFaceDetector
+int RunTiled(const std::vector<std::string>& paths, int min_face) {
+  vc::TileOptions options;
+  options.min_face = min_face;
+  vc::TiledFaceDetector detector(options, vc::TaskPool::Instance().NumWorkers() + 1);
+
+  int failed = 0;
+  for (const auto& path : paths) {
+    auto image = cv::imread(path, cv::IMREAD_COLOR);
+    if (image.empty()) {
+      fprintf(stderr, "Cannot read %s\n", path.c_str());
+      ++failed;
+      continue;
+    }
+
+    auto image_desc = vc::ImageDesc::Packed(vc::PixelFormat::kBGR, image.data, image.cols, image.rows,
+                                            static_cast<int>(image.step));
+    auto faces = detector.Detect(image_desc);
+    const auto& run = detector.LastRun();
+
+    printf("{\"path\": \"%s\", \"width\": %d, \"height\": %d, \"faces\": [", path.c_str(), image.cols, image.rows);
+    for (size_t i = 0; i < faces.size(); ++i) {
+      const auto& roi = faces[i].roi;
+      printf("%s{\"roi\": [%d, %d, %d, %d], \"score\": %.3f}", i ? ", " : "", roi[0], roi[1], roi[2], roi[3],
+             faces[i].score);
+    }
+    printf("], \"levels\": %d, \"tiles\": %d, \"invokes\": %d, \"candidates\": %d, \"ms\": %.3f}\n",
+           run.levels, run.tiles, run.invokes, run.candidates, run.ms);
+  }
+  return failed == 0 ? 0 : 1;
+}
+
+} // namespace
+
+// Native command line driver, prints one JSON line per image:
+//   FaceDetectCli [--threads N] [--tiled [--min-face PX]] image...
+// JPEGs are decoded at the smallest DCT scale that still fills the model input, coordinates are
+// of the original image. --tiled finds every face down to --min-face pixels (default 20) instead
+// of the best one, on the image at full resolution, with a single-threaded interpreter per task
+// pool lane.
+int main(int argc, char** argv) {
+  int num_threads = 2;
+  bool tiled = false;
+  int min_face = 20;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--tiled") == 0) {
+      tiled = true;
+    } else if (std::strcmp(argv[i], "--min-face") == 0 && i + 1 < argc) {
+      min_face = std::atoi(argv[++i]);
+    } else {
+      paths.emplace_back(argv[i]);
+    }
+  }
+
+  if (paths.empty()) {
+    fprintf(stderr, "Usage: %s [--threads N] [--tiled [--min-face PX]] image...\n", argv[0]);
+    return 1;
+  }
+  if (tiled)
+    return RunTiled(paths, min_face);
+
+  vc::BlazeFaceWrapper face_wrapper(num_threads);
+  face_wrapper.Warmup();
+  vc::JpegDecoder decoder(vc::BlazeFaceShortRange::kInputWidth, vc::BlazeFaceShortRange::kInputHeight);
+
+  int failed = 0;
+  for (const auto& path : paths) {
+    auto decode_start = vc::NowMs();
+    const auto& image = decoder.DecodeFile(path);
+    auto decode_ms = vc::NowMs() - decode_start;
+    if (image.empty()) {
+      fprintf(stderr, "Cannot read %s\n", path.c_str());
+      ++failed;
+      continue;
+    }
+
+    auto image_desc = vc::ImageDesc::Packed(vc::PixelFormat::kBGR, image.data, image.cols, image.rows,
+                                            static_cast<int>(image.step));
+    auto start_time = vc::NowMs();
+    auto [roi, angle] = face_wrapper.Execute(image_desc, 0);
+    auto elapsed = vc::NowMs() - start_time;
+
+    printf("{\"path\": \"%s\", \"width\": %d, \"height\": %d, \"decode_scale\": %.3f, \"found\": %s",
+           path.c_str(), decoder.Width(), decoder.Height(), decoder.Scale(), roi.empty() ? "false" : "true");
+    if (!roi.empty()) {
+      auto scale = decoder.Scale();
+      for (auto& value : roi) value = static_cast<int>(std::lround(value * scale));
+      printf(", \"roi\": [%d, %d, %d, %d], \"angle_degree\": %.2f",
+             roi[0], roi[1], roi[2], roi[3], angle * 180 / vccc::math_constant::pi<double>);
+    }
+    printf(", \"decode_ms\": %.3f, \"ms\": %.3f}\n", decode_ms, elapsed);
+  }
+
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#ifndef WASMSAMPLE_CONCURRENT_SIGNAL_H_
+#define WASMSAMPLE_CONCURRENT_SIGNAL_H_
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/threading.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace vc {
+
+// Sequence counter a worker can sleep on.
+//
+// Notify() never takes a lock on Emscripten, so it is safe to call from the browser main thread,
+// where blocking on a contended mutex turns into a busy-wait.
+class Signal {
+ public:
+  uint32_t Sequence() const {
+    return sequence.load(std::memory_order_acquire);
+  }
+
+  void Notify() {
+    sequence.fetch_add(1, std::memory_order_acq_rel);
+#ifdef __EMSCRIPTEN__
+    emscripten_futex_wake(&sequence, 1);
+#else
+    { std::lock_guard<std::mutex> lock(mutex); }
+    cv.notify_one();
+#endif
+  }
+
+  // Blocks until Sequence() != seen or timeout_ms elapsed.
+  void Wait(uint32_t seen, double timeout_ms) {
+#ifdef __EMSCRIPTEN__
+    emscripten_futex_wait(&sequence, seen, timeout_ms);
+#else
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait_for(lock, std::chrono::duration<double, std::milli>(timeout_ms),
+                [&] { return Sequence() != seen; });
+#endif
+  }
+
+ private:
+  std::atomic<uint32_t> sequence{0};
+#ifndef __EMSCRIPTEN__
+  std::mutex mutex;
+  std::condition_variable cv;
+#endif
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_CONCURRENT_SIGNAL_H_
@@ -0,0 +1,76 @@
+#ifndef WASMSAMPLE_CONCURRENT_TASK_POOL_H_
+#define WASMSAMPLE_CONCURRENT_TASK_POOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "concurrent/signal.h"
+
+namespace vc {
+
+// Application-wide work-stealing thread pool for image work and detector tasks.
+//
+// Each worker has its own deque: tasks submitted by a worker go to its own deque and are run
+// newest first, other tasks are spread over the deques, and an idle worker steals the oldest task
+// of another one. Workers are started on first use and never exit.
+//
+// TFLite 2.5 cannot run its kernels on it: XNNPACK creates a pthreadpool per interpreter and the
+// external CPU backend context only carries ruy's own pool. The pool therefore takes a fixed share
+// of PTHREAD_POOL_SIZE, and ThreadTuner and the QoS ladder keep interpreters under
+// MaxInterpreterThreads() so both fit in the pthread pool.
+class TaskPool {
+ public:
+  static TaskPool& Instance();
+
+  // Number of workers Instance() starts with, call before its first use. Default is
+  // PTHREAD_POOL_SIZE / 2, at least 1, and 0 disables the pool (everything runs on the caller).
+  static void Configure(int num_workers);
+
+  // Interpreter threads left by the pool's workers in PTHREAD_POOL_SIZE, at least 1. Does not start
+  // the pool.
+  static int MaxInterpreterThreads();
+
+  explicit TaskPool(int num_workers);
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator = (const TaskPool&) = delete;
+
+  int NumWorkers() const { return static_cast<int>(workers.size()); }
+
+  void Submit(std::function<void()> task);
+
+  // Calls fn(index, lane) for every index in [0, count) and returns when all calls are done.
+  //
+  // Indices are claimed one at a time by up to max_lanes lanes: lane 0 is the calling thread, the
+  // others run as pool tasks. Calls on the same lane never overlap, so lane can select per-thread
+  // state. The caller never waits for a lane that has not started, so nesting is safe and a busy
+  // pool only costs parallelism.
+  void ParallelFor(int count, int max_lanes, const std::function<void(int index, int lane)>& fn);
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void Loop(int index);
+  bool Pop(int index, std::function<void()>& task);
+  bool Steal(int thief, std::function<void()>& task);
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<int> pending{0};
+  std::atomic<unsigned> next_queue{0};
+  std::atomic<bool> running{true};
+  Signal task_signal;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_CONCURRENT_TASK_POOL_H_
@@ -0,0 +1,107 @@
+#include "detector/async_face_detector.h"
+
+#include "profile/trace_recorder.h"
+#include "vccc/log.hpp"
+
+namespace vc {
+
+AsyncFaceDetector::AsyncFaceDetector() = default;
+
+AsyncFaceDetector::~AsyncFaceDetector() {
+  Stop();
+}
+
+void AsyncFaceDetector::Start() {
+  if (running.exchange(true))
+    return;
+  worker = std::thread(&AsyncFaceDetector::Loop, this);
+}
+
+void AsyncFaceDetector::Stop() {
+  if (!running.exchange(false))
+    return;
+  frame_signal.Notify();
+  if (worker.joinable())
+    worker.join();
+}
+
+bool AsyncFaceDetector::IsRunning() const {
+  return running.load(std::memory_order_acquire);
+}
+
+uint64_t AsyncFaceDetector::Submit(const unsigned char* rgba, int width, int height) {
+  return Submit(ImageDesc::Packed(PixelFormat::kRGBA, rgba, width, height));
+}
+
+uint64_t AsyncFaceDetector::Submit(const ImageDesc& image) {
+  auto id = submitted.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  auto& frame = frames.WriteSlot();
+  frame.image = CopyImage(image, frame.pixels);
+  frame.id = id;
+  if (frame.pixels.capacity() > frame_bytes.load(std::memory_order_relaxed))
+    frame_bytes.store(frame.pixels.capacity(), std::memory_order_relaxed);
+
+  if (frames.Publish())
+    dropped.fetch_add(1, std::memory_order_relaxed);
+  frame_signal.Notify();
+  return id;
+}
+
+bool AsyncFaceDetector::Poll(FaceResult& result) {
+  if (!results.Acquire())
+    return false;
+  result = results.ReadSlot();
+  return true;
+}
+
+AsyncFaceDetector::Stats AsyncFaceDetector::GetStats() const {
+  Stats stats;
+  stats.submitted = submitted.load(std::memory_order_relaxed);
+  stats.processed = processed.load(std::memory_order_relaxed);
+  stats.dropped = dropped.load(std::memory_order_relaxed);
+  return stats;
+}
+
+DetectorStats AsyncFaceDetector::SnapshotDetectorStats(bool reset) {
+  return face_wrapper.SnapshotStats(reset);
+}
+
+MemoryReport AsyncFaceDetector::MemoryUsage() const {
+  auto report = face_wrapper.MemoryUsage();
+  // Each of the three mailbox slots ends up holding a copy of the largest frame
+  report.frame_buffer_bytes = 3 * frame_bytes.load(std::memory_order_relaxed);
+  return report;
+}
+
+void AsyncFaceDetector::Loop() {
+  LOGD("Async face detector started");
+  TraceRecorder::Instance().SetThreadName("face_detector");
+
+  while (running.load(std::memory_order_acquire)) {
+    // Read the sequence before checking the mailbox so a frame published in between wakes us up.
+    auto seen = frame_signal.Sequence();
+    if (!frames.Acquire()) {
+      frame_signal.Wait(seen, 100);
+      continue;
+    }
+
+    const auto& frame = frames.ReadSlot();
+    ScopedTrace trace("detectFrame", "api");
+    auto [roi, angle] = face_wrapper.Execute(frame.image, prior_angle);
+    prior_angle = angle;
+
+    auto& result = results.WriteSlot();
+    result.found = !roi.empty();
+    result.roi = std::move(roi);
+    result.angle = angle;
+    result.frame_id = frame.id;
+    results.Publish();
+
+    processed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  LOGD("Async face detector stopped");
+}
+
+} // namespace vc
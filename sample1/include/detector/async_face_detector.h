@@ -0,0 +1,82 @@
+#ifndef WASMSAMPLE_DETECTOR_ASYNC_FACE_DETECTOR_H_
+#define WASMSAMPLE_DETECTOR_ASYNC_FACE_DETECTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "concurrent/latest_mailbox.h"
+#include "concurrent/signal.h"
+#include "detector/face_result.h"
+#include "image/image_desc.h"
+
+namespace vc {
+
+// Runs BlazeFaceWrapper on its own thread.
+//
+// Frames are handed over through a latest-frame mailbox: Submit() never blocks, and a frame that
+// was not picked up before the next one arrives is dropped. Results are published the same way
+// and picked up with Poll(). The rotation prior is tracked internally from the previous result.
+class AsyncFaceDetector {
+ public:
+  struct Stats {
+    uint64_t submitted = 0;
+    uint64_t processed = 0;
+    uint64_t dropped = 0;
+  };
+
+  AsyncFaceDetector();
+  ~AsyncFaceDetector();
+
+  AsyncFaceDetector(const AsyncFaceDetector&) = delete;
+  AsyncFaceDetector& operator = (const AsyncFaceDetector&) = delete;
+
+  void Start();
+  void Stop();
+  bool IsRunning() const;
+
+  // Copies a frame into the mailbox and returns its frame id.
+  uint64_t Submit(const ImageDesc& image);
+  uint64_t Submit(const unsigned char* rgba, int width, int height);
+
+  // Returns true and fills result if a result newer than the last polled one is available.
+  bool Poll(FaceResult& result);
+
+  Stats GetStats() const;
+
+  // Latency counters of the detector thread's BlazeFaceWrapper
+  DetectorStats SnapshotDetectorStats(bool reset);
+
+  // The detector's BlazeFaceWrapper report plus the mailbox frame copies
+  MemoryReport MemoryUsage() const;
+
+ private:
+  struct Frame {
+    std::vector<unsigned char> pixels;
+    ImageDesc image;
+    uint64_t id = 0;
+  };
+
+  void Loop();
+
+  BlazeFaceWrapper face_wrapper;
+  Angle prior_angle = 0;
+
+  LatestMailbox<Frame> frames;
+  LatestMailbox<FaceResult> results;
+  Signal frame_signal;
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+
+  std::atomic<uint64_t> submitted{0};
+  std::atomic<uint64_t> processed{0};
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<size_t> frame_bytes{0};  // largest frame copy so far
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_ASYNC_FACE_DETECTOR_H_
@@ -0,0 +1,42 @@
+#ifndef WASMSAMPLE_DETECTOR_BATCH_FACE_DETECTOR_H_
+#define WASMSAMPLE_DETECTOR_BATCH_FACE_DETECTOR_H_
+
+#include <memory>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "detector/face_result.h"
+#include "image/image_desc.h"
+
+namespace vc {
+
+// Runs independent images in parallel for offline processing.
+//
+// Every worker owns a BlazeFaceWrapper, i.e. its own single-threaded interpreter and input tensor,
+// so workers never share scratch memory. The calling thread takes part as one of the workers and
+// Detect() blocks until the whole batch is done.
+//
+// The images are spread over TaskPool lanes, so at most TaskPool::NumWorkers() + 1 workers run at
+// once; with a busy pool the caller goes through the batch alone.
+//
+// With a MemoryBudget set, fewer workers are created when the heap taken by the first one says the
+// rest would not fit; NumWorkers() tells how many there are.
+class BatchFaceDetector {
+ public:
+  explicit BatchFaceDetector(int num_workers);
+
+  int NumWorkers() const;
+
+  // results must hold count entries. frame_id of each result is the index of its image.
+  void Detect(const ImageDesc* images, int count, FaceResult* results);
+
+  // Arenas summed over the workers, which all share the embedded model
+  MemoryReport MemoryUsage() const;
+
+ private:
+  std::vector<std::unique_ptr<BlazeFaceWrapper>> workers;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_BATCH_FACE_DETECTOR_H_
@@ -0,0 +1,77 @@
+#include "detector/cascade_detector.h"
+
+#include "profile/trace_recorder.h"
+
+namespace vc {
+
+CascadeDetector::CascadeDetector(const CascadeStageOptions& stage_options, float track_score, int num_threads)
+  : face_wrapper(num_threads),
+    stage(stage_options),
+    track_score(track_score) {}
+
+void CascadeDetector::Reset() {
+  tracking = false;
+  tracked_roi.clear();
+  angle = 0;
+}
+
+// BlazeFaceWrapper::Run with the raw outputs in the shared scratch buffer
+Detection CascadeDetector::RunDetector(const ImageDesc& frame) {
+  ScopedTrace trace("cascadeDetector", "stage");
+  face_wrapper.PreProcess(frame, angle);
+  face_wrapper.model.invoke();
+
+  auto& model = face_wrapper.model;
+  auto boxes_size = model.outputBytes(face_wrapper.r_index) / sizeof(float);
+  auto scores_size = model.outputBytes(face_wrapper.c_index) / sizeof(float);
+  scratch.resize(boxes_size + scores_size);
+  model.copyOutput(face_wrapper.r_index, scratch.data());
+  model.copyOutput(face_wrapper.c_index, scratch.data() + boxes_size);
+  return face_wrapper.PostProcess(scratch.data(), scratch.data() + boxes_size, scores_size,
+                                  face_wrapper.letterbox, angle);
+}
+
+CascadeResult CascadeDetector::Detect(const ImageDesc& frame) {
+  ScopedTrace trace("cascadeDetect", "api");
+  CascadeResult result;
+  if (frame.empty())
+    return result;
+
+  // A lost track falls back to the detector on the same frame
+  if (tracking) {
+    result.stage = stage.Run(frame, tracked_roi, angle, scratch);
+    if (result.stage.found) {
+      ++detector_skips;
+      result.detector_skipped = true;
+      result.crop_roi = tracked_roi;
+    } else {
+      Reset();
+    }
+  }
+
+  if (!result.detector_skipped) {
+    auto [roi, score, landmarks] = RunDetector(frame);
+    ++detector_runs;
+    if (roi.empty()) {
+      Reset();
+      return result;
+    }
+    result.crop_roi = roi;
+    angle = BlazeFaceWrapper::CalculateFaceAngleFromLandmarks(landmarks);
+    result.stage = stage.Run(frame, roi, angle, scratch);
+  }
+
+  result.found = result.stage.found;
+  if (!result.found) {
+    Reset();
+    return result;
+  }
+
+  // The landmark box is tighter than a detector box, the stage's roi_scale covers the difference
+  tracking = result.stage.score >= track_score;
+  tracked_roi = result.stage.roi;
+  angle = result.stage.angle;
+  return result;
+}
+
+} // namespace vc
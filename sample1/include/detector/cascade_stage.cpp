@@ -0,0 +1,100 @@
+#include "detector/cascade_stage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "profile/trace_recorder.h"
+
+namespace vc {
+
+CascadeStage::CascadeStage(const CascadeStageOptions& options)
+  : options(options),
+    model_data(static_cast<const char*>(options.model_buffer),
+               static_cast<const char*>(options.model_buffer) + options.model_size) {
+  assert(((void)"Cascade stage needs a model", !model_data.empty()));
+
+  // The flatbuffer is not copied by TFLite, so the stage keeps its own copy alive
+  cute::CuteModelBuilder(cute::CuteModelBuilderOptions(model_data.data(), model_data.size(),
+                                                       options.num_threads)).build(model);
+  auto dims = model.inputTensorDims(0);
+  input_height = dims[1];
+  input_width = dims[2];
+}
+
+AffineMap CascadeStage::CropMap(const ROI& roi, Angle angle) const {
+  auto cx = (roi[0] + roi[2]) / 2.0, cy = (roi[1] + roi[3]) / 2.0;
+  auto side = std::max(roi[2] - roi[0], roi[3] - roi[1]) * static_cast<double>(options.roi_scale);
+  auto sx = side / input_width, sy = side / input_height;
+  auto c = std::cos(angle), s = std::sin(angle);
+
+  // Crop axes are the face axes: x along (cos, sin), y along (-sin, cos). Pixel centers are mapped
+  // to pixel centers.
+  AffineMap map;
+  map.m[0] = static_cast<float>(c * sx);
+  map.m[1] = static_cast<float>(-s * sy);
+  map.m[3] = static_cast<float>(s * sx);
+  map.m[4] = static_cast<float>(c * sy);
+  auto u0 = 0.5 * sx - side / 2, v0 = 0.5 * sy - side / 2;
+  map.m[2] = static_cast<float>(cx + c * u0 - s * v0 - 0.5);
+  map.m[5] = static_cast<float>(cy + s * u0 + c * v0 - 0.5);
+  return map;
+}
+
+CascadeStageResult CascadeStage::Run(const ImageDesc& frame, const ROI& roi, Angle angle,
+                                     std::vector<float>& scratch) {
+  ScopedTrace trace("cascadeStage", "stage");
+  CascadeStageResult result;
+  result.angle = angle;
+  if (frame.empty() || roi.size() < 4)
+    return result;
+
+  auto map = CropMap(roi, angle);
+  SampleRGB(frame, map, static_cast<float*>(model.inputData(0)), input_width, input_height,
+            options.input_alpha, options.input_beta);
+  model.invoke();
+
+  if (options.score_output >= 0) {
+    scratch.resize(model.outputBytes(options.score_output) / sizeof(float));
+    model.copyOutput(options.score_output, scratch.data());
+    result.score = static_cast<Score>(1. / (1. + std::exp(-scratch[0])));
+    if (result.score < options.min_score)
+      return result;
+  } else {
+    result.score = 1;
+  }
+
+  scratch.resize(model.outputBytes(options.landmark_output) / sizeof(float));
+  model.copyOutput(options.landmark_output, scratch.data());
+
+  auto count = scratch.size() / options.landmark_stride;
+  result.landmarks.reserve(count);
+  const auto& m = map.m;
+  for (size_t i = 0; i < count; ++i) {
+    // Landmark coordinates are continuous, shift to the pixel-center convention of the map
+    auto u = scratch[i * options.landmark_stride] - 0.5f;
+    auto v = scratch[i * options.landmark_stride + 1] - 0.5f;
+    result.landmarks.emplace_back(m[0] * u + m[1] * v + m[2] + 0.5f, m[3] * u + m[4] * v + m[5] + 0.5f);
+  }
+  if (result.landmarks.empty())
+    return result;
+
+  auto [min_x, max_x] = std::minmax_element(result.landmarks.begin(), result.landmarks.end(),
+                                            [](const Point& a, const Point& b) { return a.x < b.x; });
+  auto [min_y, max_y] = std::minmax_element(result.landmarks.begin(), result.landmarks.end(),
+                                            [](const Point& a, const Point& b) { return a.y < b.y; });
+  result.roi = {static_cast<int>(min_x->x), static_cast<int>(min_y->y),
+                static_cast<int>(std::ceil(max_x->x)), static_cast<int>(std::ceil(max_y->y))};
+
+  if (options.angle_from >= 0 && options.angle_to >= 0 &&
+      static_cast<size_t>(std::max(options.angle_from, options.angle_to)) < count) {
+    const auto& from = result.landmarks[options.angle_from];
+    const auto& to = result.landmarks[options.angle_to];
+    result.angle = std::atan2(to.y - from.y, to.x - from.x);
+  }
+
+  result.found = true;
+  return result;
+}
+
+} // namespace vc
@@ -0,0 +1,71 @@
+#ifndef WASMSAMPLE_DETECTOR_CASCADE_STAGE_H_
+#define WASMSAMPLE_DETECTOR_CASCADE_STAGE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "cutemodel/cute_model.h"
+#include "image/fused_sampler.h"
+#include "image/image_desc.h"
+
+namespace vc {
+
+// Second-stage model run on a face crop, e.g. a face mesh or eye model with a [1, H, W, 3] float
+// input and a landmark output of (x, y[, z]) per point in input pixels.
+struct CascadeStageOptions {
+  const void* model_buffer = nullptr;  // copied, may be freed after construction
+  size_t model_size = 0;
+  int num_threads = 1;
+
+  float roi_scale = 1.5f;        // side of the square crop, relative to the larger ROI side
+  float input_alpha = 1 / 255.f; // input = pixel * alpha + beta
+  float input_beta = 0;
+
+  int landmark_output = 0;
+  int landmark_stride = 3;
+  int score_output = -1;         // confidence logit output, -1 if the model has none
+  float min_score = 0.5f;        // below it the stage reports no face
+
+  // Landmarks whose direction gives the face angle on the next frame, -1 keeps the crop angle
+  int angle_from = -1;
+  int angle_to = -1;
+};
+
+struct CascadeStageResult {
+  bool found = false;
+  Score score = 0;
+  Points landmarks;  // frame pixels
+  ROI roi;           // bounding box of the landmarks
+  Angle angle = 0;
+};
+
+// Crops and rotates the ROI out of the full-resolution frame straight into the input tensor,
+// without an intermediate image, and maps the landmarks back to frame pixels.
+class CascadeStage {
+ public:
+  explicit CascadeStage(const CascadeStageOptions& options);
+
+  CascadeStage(const CascadeStage&) = delete;
+  CascadeStage& operator = (const CascadeStage&) = delete;
+
+  // roi is a detector box in frame pixels, angle the face rotation in radians. scratch receives the
+  // raw outputs and can be shared with other stages of the frame.
+  CascadeStageResult Run(const ImageDesc& frame, const ROI& roi, Angle angle, std::vector<float>& scratch);
+
+  const CascadeStageOptions& Options() const { return options; }
+
+ private:
+  // Crop pixel -> frame pixel
+  AffineMap CropMap(const ROI& roi, Angle angle) const;
+
+  CascadeStageOptions options;
+  std::vector<char> model_data;
+  cute::CuteModel model;
+  int input_width = 0;
+  int input_height = 0;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_CASCADE_STAGE_H_
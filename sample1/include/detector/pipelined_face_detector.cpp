@@ -0,0 +1,210 @@
+#include "detector/pipelined_face_detector.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "concurrent/task_pool.h"
+#include "profile/clock.h"
+#include "profile/trace_recorder.h"
+#include "vccc/log.hpp"
+
+namespace vc {
+
+namespace {
+
+// Pops from queue, sleeping on signal for at most timeout_ms
+template<typename Queue, typename T>
+bool PopWait(Queue& queue, Signal& signal, T& value, double timeout_ms) {
+  auto deadline = NowMs() + timeout_ms;
+  while (true) {
+    // Read the sequence before checking the queue so a push in between wakes us up.
+    auto seen = signal.Sequence();
+    if (queue.TryPop(value))
+      return true;
+    auto remaining = deadline - NowMs();
+    if (remaining <= 0)
+      return false;
+    signal.Wait(seen, remaining);
+  }
+}
+
+} // namespace
+
+PipelinedFaceDetector::PipelinedFaceDetector()
+  : face_wrapper(1) {
+  const auto& target_size = face_wrapper.target_size;
+  context_tensor_bytes = static_cast<size_t>(target_size[0]) * target_size[1] * 3 * sizeof(float)
+                         + face_wrapper.model.outputBytes(face_wrapper.r_index)
+                         + face_wrapper.model.outputBytes(face_wrapper.c_index);
+}
+
+PipelinedFaceDetector::~PipelinedFaceDetector() {
+  Stop();
+}
+
+void PipelinedFaceDetector::Start() {
+  if (running.exchange(true))
+    return;
+
+  // Frames that were in flight when the pipeline was stopped are discarded
+  for (auto* channel : {&free_contexts, &submitted_frames, &preprocessed_frames, &inferred_frames})
+    channel->queue.Clear();
+  results.Clear();
+
+  // Buffers of the contexts are allocated on first use and kept across restarts
+  auto seen_frame_bytes = frame_bytes.load(std::memory_order_relaxed);
+  auto context_bytes = context_tensor_bytes + (seen_frame_bytes > 0 ? seen_frame_bytes : kFrameBytesEstimate);
+  depth = static_cast<size_t>(MemoryBudget::Instance().Fit(static_cast<int>(kDepth), context_bytes));
+  if (depth < kDepth)
+    LOGD("Pipelined face detector: ", depth, " of ", kDepth, " frame contexts fit the memory budget");
+
+  if (TaskPool::MaxInterpreterThreads() < kStageThreads)
+    LOGD("Pipelined face detector: ", kStageThreads, " stage threads and the task pool's workers exceed "
+         "PTHREAD_POOL_SIZE ", PTHREAD_POOL_SIZE, ", stages may never start");
+
+  const auto& target_size = face_wrapper.target_size;
+  for (size_t i = 0; i < depth; ++i) {
+    auto& ctx = contexts[i];
+    ctx.input.resize(static_cast<size_t>(target_size[0]) * target_size[1] * 3);
+    ctx.boxes.resize(face_wrapper.model.outputBytes(face_wrapper.r_index) / sizeof(float));
+    ctx.scores.resize(face_wrapper.model.outputBytes(face_wrapper.c_index) / sizeof(float));
+    free_contexts.queue.TryPush(&ctx);
+  }
+
+  workers.emplace_back([this] {
+    StageLoop("pipeline_preprocess", submitted_frames, preprocessed_frames,
+              [this](FrameContext& ctx) { PreProcess(ctx); });
+  });
+  workers.emplace_back([this] {
+    StageLoop("pipeline_invoke", preprocessed_frames, inferred_frames,
+              [this](FrameContext& ctx) { Invoke(ctx); });
+  });
+  workers.emplace_back([this] {
+    StageLoop("pipeline_postprocess", inferred_frames, free_contexts,
+              [this](FrameContext& ctx) { PostProcess(ctx); });
+  });
+}
+
+void PipelinedFaceDetector::Stop() {
+  if (!running.exchange(false))
+    return;
+  for (auto* channel : {&submitted_frames, &preprocessed_frames, &inferred_frames})
+    channel->signal.Notify();
+  for (auto& worker : workers)
+    worker.join();
+  workers.clear();
+}
+
+bool PipelinedFaceDetector::IsRunning() const {
+  return running.load(std::memory_order_acquire);
+}
+
+uint64_t PipelinedFaceDetector::Submit(const ImageDesc& image, double timeout_ms) {
+  FrameContext* ctx = nullptr;
+  if (!IsRunning() || !PopWait(free_contexts.queue, free_contexts.signal, ctx, timeout_ms)) {
+    rejected.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  ctx->id = submitted.fetch_add(1, std::memory_order_relaxed) + 1;
+  ctx->times.clear();
+  {
+    ScopedStage timer(ctx->times, Stage::kColorConvert);
+    ctx->image = CopyImage(image, ctx->pixels);
+  }
+  if (ctx->pixels.capacity() > frame_bytes.load(std::memory_order_relaxed))
+    frame_bytes.store(ctx->pixels.capacity(), std::memory_order_relaxed);
+
+  // Never fails, the queue can hold every context
+  submitted_frames.queue.TryPush(ctx);
+  submitted_frames.signal.Notify();
+  return ctx->id;
+}
+
+bool PipelinedFaceDetector::Poll(FaceResult& result) {
+  return results.TryPop(result);
+}
+
+bool PipelinedFaceDetector::Poll(FaceResult& result, double timeout_ms) {
+  return PopWait(results, result_signal, result, timeout_ms);
+}
+
+PipelinedFaceDetector::Stats PipelinedFaceDetector::GetStats() const {
+  Stats stats;
+  stats.submitted = submitted.load(std::memory_order_relaxed);
+  stats.processed = processed.load(std::memory_order_relaxed);
+  stats.rejected = rejected.load(std::memory_order_relaxed);
+  stats.results_dropped = results_dropped.load(std::memory_order_relaxed);
+  return stats;
+}
+
+DetectorStats PipelinedFaceDetector::SnapshotDetectorStats(bool reset) {
+  return face_wrapper.SnapshotStats(reset);
+}
+
+size_t PipelinedFaceDetector::Depth() const {
+  return depth;
+}
+
+MemoryReport PipelinedFaceDetector::MemoryUsage() const {
+  auto report = face_wrapper.MemoryUsage();
+  report.frame_buffer_bytes = depth * (context_tensor_bytes + frame_bytes.load(std::memory_order_relaxed));
+  return report;
+}
+
+template<typename Process>
+void PipelinedFaceDetector::StageLoop(const char* thread_name, Channel& input, Channel& output, Process process) {
+  LOGD("Pipeline stage started: ", thread_name);
+  TraceRecorder::Instance().SetThreadName(thread_name);
+
+  while (running.load(std::memory_order_acquire)) {
+    FrameContext* ctx = nullptr;
+    if (!PopWait(input.queue, input.signal, ctx, 100))
+      continue;
+
+    process(*ctx);
+
+    output.queue.TryPush(ctx);
+    output.signal.Notify();
+  }
+}
+
+void PipelinedFaceDetector::PreProcess(FrameContext& ctx) {
+  ScopedStage timer(ctx.times, Stage::kSample);
+  ctx.angle = prior_angle.load(std::memory_order_relaxed);
+  ctx.letterbox = face_wrapper.ComputeLetterbox(ctx.image.width, ctx.image.height);
+  face_wrapper.SampleInput(ctx.image, ctx.letterbox, ctx.angle, ctx.input.data());
+}
+
+void PipelinedFaceDetector::Invoke(FrameContext& ctx) {
+  ScopedStage timer(ctx.times, Stage::kInvoke);
+  auto& model = face_wrapper.model;
+  std::memcpy(model.inputData(0), ctx.input.data(), ctx.input.size() * sizeof(float));
+  model.invoke();
+  model.copyOutput(face_wrapper.r_index, ctx.boxes.data());
+  model.copyOutput(face_wrapper.c_index, ctx.scores.data());
+}
+
+void PipelinedFaceDetector::PostProcess(FrameContext& ctx) {
+  FaceResult result;
+  Score score;
+  {
+    ScopedStage timer(ctx.times, Stage::kPostProcess);
+    Points landmarks;
+    std::tie(result.roi, score, landmarks) =
+        face_wrapper.PostProcess(ctx.boxes.data(), ctx.scores.data(), ctx.scores.size(), ctx.letterbox, ctx.angle);
+    result.found = !result.roi.empty();
+    result.angle = result.found ? BlazeFaceWrapper::CalculateFaceAngleFromLandmarks(landmarks) : 0;
+    result.frame_id = ctx.id;
+  }
+
+  face_wrapper.stats.Record(ctx.times, result.found, score);
+  prior_angle.store(result.angle, std::memory_order_relaxed);
+
+  if (!results.TryPush(std::move(result)))
+    results_dropped.fetch_add(1, std::memory_order_relaxed);
+  result_signal.Notify();
+  processed.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace vc
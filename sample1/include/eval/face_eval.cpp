@@ -0,0 +1,260 @@
+#include "eval/face_eval.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "profile/clock.h"
+
+namespace vc {
+namespace eval {
+
+namespace {
+
+constexpr int kKeypoints = 6;
+
+double Distance(const Point& a, const Point& b) {
+  return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+double Percentile(std::vector<double> values, double p) {
+  if (values.empty()) return 0;
+  auto index = static_cast<size_t>(p * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+// Scales a detection on a downscaled or cropped frame back to frame pixels
+FaceDetection MapToFrame(FaceDetection detection, double scale, int offset_x, int offset_y) {
+  if (detection.roi.empty())
+    return detection;
+  for (int i = 0; i < 4; ++i)
+    detection.roi[i] = static_cast<int>(std::lround(detection.roi[i] * scale)) + (i % 2 == 0 ? offset_x : offset_y);
+  for (auto& point : detection.landmarks) {
+    point.x = static_cast<float>(point.x * scale + offset_x);
+    point.y = static_cast<float>(point.y * scale + offset_y);
+  }
+  return detection;
+}
+
+ImageDesc BGRDesc(const cv::Mat& bgr) {
+  return ImageDesc::Packed(PixelFormat::kBGR, bgr.data, bgr.cols, bgr.rows, static_cast<int>(bgr.step));
+}
+
+class WrapperStage : public FaceEvalStage {
+ public:
+  WrapperStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper, std::string name, InputPath path, int downscale)
+    : face_wrapper(std::move(face_wrapper)), name(std::move(name)), path(path), downscale(std::max(downscale, 1)) {}
+
+  std::string Name() const override { return name; }
+
+ protected:
+  FaceDetection Detect(const cv::Mat& bgr, double& ms) override {
+    auto input = bgr;
+    if (downscale > 1)
+      cv::resize(bgr, input, {bgr.cols / downscale, bgr.rows / downscale}, 0, 0, cv::INTER_AREA);
+
+    auto start_time = NowMs();
+    FaceDetection detection;
+    if (path == InputPath::kOpenCV) {
+      cv::cvtColor(input, rgb, cv::COLOR_BGR2RGB);
+      detection = face_wrapper->Detect(rgb, 0);
+    } else {
+      detection = face_wrapper->Detect(BGRDesc(input), 0);
+    }
+    ms = NowMs() - start_time;
+    return MapToFrame(detection, static_cast<double>(bgr.cols) / input.cols, 0, 0);
+  }
+
+ private:
+  std::shared_ptr<BlazeFaceWrapper> face_wrapper;
+  std::string name;
+  InputPath path;
+  int downscale;
+  cv::Mat rgb;
+};
+
+class FrameSkipStage : public FaceEvalStage {
+ public:
+  FrameSkipStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper, int interval)
+    : face_wrapper(std::move(face_wrapper)), interval(std::max(interval, 1)) {}
+
+  std::string Name() const override { return "skip_" + std::to_string(interval); }
+
+  void Init() override {
+    frame = 0;
+    last = {};
+  }
+
+ protected:
+  FaceDetection Detect(const cv::Mat& bgr, double& ms) override {
+    auto start_time = NowMs();
+    if (frame++ % interval == 0)
+      last = face_wrapper->Detect(BGRDesc(bgr), last.angle);
+    ms = NowMs() - start_time;
+    return last;
+  }
+
+ private:
+  std::shared_ptr<BlazeFaceWrapper> face_wrapper;
+  int interval;
+  int frame = 0;
+  FaceDetection last;
+};
+
+class TrackingCropStage : public FaceEvalStage {
+ public:
+  TrackingCropStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper, double crop_scale)
+    : face_wrapper(std::move(face_wrapper)), crop_scale(crop_scale) {}
+
+  std::string Name() const override { return "tracking_crop"; }
+
+  void Init() override { last = {}; }
+
+ protected:
+  FaceDetection Detect(const cv::Mat& bgr, double& ms) override {
+    auto start_time = NowMs();
+    FaceDetection detection;
+    if (!last.roi.empty()) {
+      auto cx = (last.roi[0] + last.roi[2]) / 2, cy = (last.roi[1] + last.roi[3]) / 2;
+      auto half = static_cast<int>(std::max(last.roi[2] - last.roi[0], last.roi[3] - last.roi[1]) * crop_scale / 2);
+      auto crop = cv::Rect(cx - half, cy - half, 2 * half, 2 * half) & cv::Rect(0, 0, bgr.cols, bgr.rows);
+      if (!crop.empty())
+        detection = MapToFrame(face_wrapper->Detect(BGRDesc(bgr(crop)), last.angle), 1, crop.x, crop.y);
+    }
+    if (detection.roi.empty())
+      detection = face_wrapper->Detect(BGRDesc(bgr), 0);
+    ms = NowMs() - start_time;
+    last = detection;
+    return detection;
+  }
+
+ private:
+  std::shared_ptr<BlazeFaceWrapper> face_wrapper;
+  double crop_scale;
+  FaceDetection last;
+};
+
+} // namespace
+
+std::vector<FaceAnnotation> LoadAnnotations(const std::string& path) {
+  std::vector<FaceAnnotation> annotations;
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "Cannot read %s\n", path.c_str());
+    return {};
+  }
+
+  for (std::string line; std::getline(file, line);) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    FaceAnnotation annotation;
+    fields >> annotation.file;
+
+    std::vector<double> values;
+    for (std::string field; fields >> field;) {
+      if (field == "-") break;
+      values.push_back(std::atof(field.c_str()));
+    }
+    if (values.size() != 0 && values.size() != 4 && values.size() != 4 + 2 * kKeypoints) {
+      fprintf(stderr, "Bad annotation: %s\n", line.c_str());
+      return {};
+    }
+
+    annotation.has_face = !values.empty();
+    for (size_t i = 0; i < values.size() && i < 4; ++i)
+      annotation.roi.push_back(static_cast<int>(values[i]));
+    for (size_t i = 4; i + 1 < values.size(); i += 2)
+      annotation.landmarks.emplace_back(static_cast<float>(values[i]), static_cast<float>(values[i + 1]));
+    annotations.push_back(std::move(annotation));
+  }
+  return annotations;
+}
+
+double IoU(const ROI& a, const ROI& b) {
+  auto width = std::min(a[2], b[2]) - std::max(a[0], b[0]);
+  auto height = std::min(a[3], b[3]) - std::max(a[1], b[1]);
+  if (width <= 0 || height <= 0) return 0;
+  auto intersection = static_cast<double>(width) * height;
+  auto area_a = static_cast<double>(a[2] - a[0]) * (a[3] - a[1]);
+  auto area_b = static_cast<double>(b[2] - b[0]) * (b[3] - b[1]);
+  return intersection / (area_a + area_b - intersection);
+}
+
+void FaceEvalMetrics::Add(const FaceAnnotation& annotation, const FaceDetection& detection, double ms) {
+  ++images;
+  latencies_ms.push_back(ms);
+  auto detected = !detection.roi.empty();
+
+  if (!annotation.has_face) {
+    false_positives += detected;
+    return;
+  }
+
+  ++faces;
+  auto iou = detected ? IoU(annotation.roi, detection.roi) : 0.0;
+  if (iou < kMatchIoU) {
+    ++misses;
+    false_positives += detected;
+    return;
+  }
+
+  ++matched;
+  iou_sum += iou;
+
+  // Normalized by the annotated distance between the eyes (keypoints 0 and 1)
+  if (annotation.landmarks.size() == kKeypoints && detection.landmarks.size() == kKeypoints) {
+    auto inter_eye = Distance(annotation.landmarks[0], annotation.landmarks[1]);
+    if (inter_eye > 0) {
+      double error = 0;
+      for (int i = 0; i < kKeypoints; ++i)
+        error += Distance(annotation.landmarks[i], detection.landmarks[i]);
+      keypoint_error_sum += error / kKeypoints / inter_eye;
+      ++keypoint_faces;
+    }
+  }
+}
+
+std::string FaceEvalMetrics::ToJson() const {
+  double mean_ms = 0;
+  for (auto ms : latencies_ms) mean_ms += ms;
+  if (!latencies_ms.empty()) mean_ms /= latencies_ms.size();
+
+  std::stringstream out;
+  out << "{\"images\":" << images
+      << ",\"faces\":" << faces
+      << ",\"miss_rate\":" << (faces > 0 ? static_cast<double>(misses) / faces : 0)
+      << ",\"false_positives\":" << false_positives
+      << ",\"mean_iou\":" << (matched > 0 ? iou_sum / matched : 0)
+      << ",\"keypoint_error\":" << (keypoint_faces > 0 ? keypoint_error_sum / keypoint_faces : 0)
+      << ",\"mean_ms\":" << mean_ms
+      << ",\"p50_ms\":" << Percentile(latencies_ms, 0.5)
+      << ",\"p90_ms\":" << Percentile(latencies_ms, 0.9) << "}";
+  return out.str();
+}
+
+void FaceEvalStage::Run(const cv::Mat& bgr, const FaceAnnotation& annotation) {
+  double ms = 0;
+  auto detection = Detect(bgr, ms);
+  metrics.Add(annotation, detection, ms);
+}
+
+std::unique_ptr<FaceEvalStage> MakeWrapperStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper,
+                                                const std::string& name, InputPath path, int downscale) {
+  return std::make_unique<WrapperStage>(std::move(face_wrapper), name, path, downscale);
+}
+
+std::unique_ptr<FaceEvalStage> MakeFrameSkipStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper, int interval) {
+  return std::make_unique<FrameSkipStage>(std::move(face_wrapper), interval);
+}
+
+std::unique_ptr<FaceEvalStage> MakeTrackingCropStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper,
+                                                     double crop_scale) {
+  return std::make_unique<TrackingCropStage>(std::move(face_wrapper), crop_scale);
+}
+
+} // namespace eval
+} // namespace vc
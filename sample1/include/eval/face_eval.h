@@ -0,0 +1,94 @@
+#ifndef WASMSAMPLE_EVAL_FACE_EVAL_H_
+#define WASMSAMPLE_EVAL_FACE_EVAL_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "opencv2/opencv.hpp"
+
+namespace vc {
+namespace eval {
+
+// One line of annotations.txt:
+//   file x0 y0 x1 y1 [x y of the 6 BlazeFace keypoints]
+//   file -                       (no face)
+// Files are evaluated in this order, which is the frame order for sequence modes.
+struct FaceAnnotation {
+  std::string file;
+  bool has_face = false;
+  ROI roi;
+  Landmarks landmarks;  // empty if not annotated
+};
+
+// Returns an empty list and prints the offending line if the file cannot be parsed
+std::vector<FaceAnnotation> LoadAnnotations(const std::string& path);
+
+// Counts and means over all Run() calls of a stage, like the LatestMetrics() of a TFLite
+// evaluation stage
+struct FaceEvalMetrics {
+  int images = 0;
+  int faces = 0;
+  int matched = 0;          // detections with IoU >= kMatchIoU
+  int misses = 0;           // annotated faces without a matching detection
+  int false_positives = 0;  // detections on images without a face, or not matching the face
+  double iou_sum = 0;
+  int keypoint_faces = 0;
+  double keypoint_error_sum = 0;  // mean keypoint distance / inter-eye distance, per matched face
+  std::vector<double> latencies_ms;
+
+  static constexpr double kMatchIoU = 0.5;
+
+  void Add(const FaceAnnotation& annotation, const FaceDetection& detection, double ms);
+  std::string ToJson() const;
+};
+
+double IoU(const ROI& a, const ROI& b);
+
+// One detector configuration under evaluation, shaped after tflite::evaluation::EvaluationStage
+// (Init / Run / LatestMetrics) without its protobuf configs.
+class FaceEvalStage {
+ public:
+  virtual ~FaceEvalStage() = default;
+
+  virtual std::string Name() const = 0;
+
+  // Called before the first frame. Stages that carry state between frames start over.
+  virtual void Init() {}
+
+  // Detects on a BGR frame and records the result. Only the detection is timed.
+  void Run(const cv::Mat& bgr, const FaceAnnotation& annotation);
+
+  const FaceEvalMetrics& LatestMetrics() const { return metrics; }
+
+ protected:
+  // Detection in frame pixels, and the milliseconds it took
+  virtual FaceDetection Detect(const cv::Mat& bgr, double& ms) = 0;
+
+ private:
+  FaceEvalMetrics metrics;
+};
+
+enum class InputPath {
+  kOpenCV,  // Execute(cv::Mat): resize, align and normalize with OpenCV
+  kFused,   // Execute(ImageDesc): single-pass sampling
+};
+
+// The wrapper on the frame, optionally downscaled by 1 / downscale first (as if the camera
+// delivered a smaller frame, so the downscale is not timed)
+std::unique_ptr<FaceEvalStage> MakeWrapperStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper,
+                                                const std::string& name, InputPath path, int downscale = 1);
+
+// Runs the detector on every interval-th frame and repeats its result in between
+std::unique_ptr<FaceEvalStage> MakeFrameSkipStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper, int interval);
+
+// Detects in a crop of crop_scale times the previous face around it, falling back to the whole
+// frame when there is no previous face or the crop has none
+std::unique_ptr<FaceEvalStage> MakeTrackingCropStage(std::shared_ptr<BlazeFaceWrapper> face_wrapper,
+                                                     double crop_scale = 2.0);
+
+} // namespace eval
+} // namespace vc
+
+#endif //WASMSAMPLE_EVAL_FACE_EVAL_H_
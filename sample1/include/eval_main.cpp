@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "eval/face_eval.h"
+
+// Accuracy next to latency of every detector configuration on an annotated folder:
+//   FaceEval [--threads N] [--model other.tflite]... folder
+// folder/annotations.txt lists the images, see vc::eval::FaceAnnotation. --model adds the fused path
+// with another model of the same geometry, e.g. a quantized one. Prints one JSON object.
+int main(int argc, char** argv) {
+  int num_threads = 1;
+  std::string folder;
+  std::vector<std::string> model_paths;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+      model_paths.emplace_back(argv[++i]);
+    } else {
+      folder = argv[i];
+    }
+  }
+
+  if (folder.empty()) {
+    fprintf(stderr, "Usage: %s [--threads N] [--model other.tflite]... folder\n", argv[0]);
+    return 1;
+  }
+
+  auto annotations = vc::eval::LoadAnnotations(folder + "/annotations.txt");
+  if (annotations.empty())
+    return 1;
+
+  using vc::eval::InputPath;
+  auto face_wrapper = std::make_shared<vc::BlazeFaceWrapper>(num_threads);
+  face_wrapper->Warmup();
+
+  std::vector<std::unique_ptr<vc::eval::FaceEvalStage>> stages;
+  stages.push_back(vc::eval::MakeWrapperStage(face_wrapper, "opencv", InputPath::kOpenCV));
+  stages.push_back(vc::eval::MakeWrapperStage(face_wrapper, "fused", InputPath::kFused));
+  stages.push_back(vc::eval::MakeWrapperStage(face_wrapper, "fused_half_res", InputPath::kFused, 2));
+  stages.push_back(vc::eval::MakeWrapperStage(face_wrapper, "fused_quarter_res", InputPath::kFused, 4));
+  stages.push_back(vc::eval::MakeFrameSkipStage(face_wrapper, 2));
+  stages.push_back(vc::eval::MakeFrameSkipStage(face_wrapper, 4));
+  stages.push_back(vc::eval::MakeTrackingCropStage(face_wrapper));
+
+  // The wrappers keep pointing into the model buffers
+  std::vector<std::vector<char>> models;
+  models.reserve(model_paths.size());
+  for (const auto& path : model_paths) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      fprintf(stderr, "Cannot read %s\n", path.c_str());
+      return 1;
+    }
+    models.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    auto model_wrapper = std::make_shared<vc::BlazeFaceWrapper>(models.back().data(), models.back().size(), num_threads);
+    model_wrapper->Warmup();
+    auto name = "model:" + path.substr(path.find_last_of('/') + 1);
+    stages.push_back(vc::eval::MakeWrapperStage(model_wrapper, name, InputPath::kFused));
+  }
+
+  for (auto& stage : stages)
+    stage->Init();
+
+  // Frames are read once and go through every stage in order, so sequence stages see a sequence
+  int unreadable = 0;
+  for (const auto& annotation : annotations) {
+    auto image = cv::imread(folder + "/" + annotation.file, cv::IMREAD_COLOR);
+    if (image.empty()) {
+      fprintf(stderr, "Cannot read %s\n", annotation.file.c_str());
+      ++unreadable;
+      continue;
+    }
+    for (auto& stage : stages)
+      stage->Run(image, annotation);
+  }
+
+  printf("{\"folder\": \"%s\", \"threads\": %d, \"unreadable\": %d, \"configs\": [\n",
+         folder.c_str(), num_threads, unreadable);
+  for (size_t i = 0; i < stages.size(); ++i) {
+    printf("  {\"name\": \"%s\", \"metrics\": %s}%s\n", stages[i]->Name().c_str(),
+           stages[i]->LatestMetrics().ToJson().c_str(), i + 1 == stages.size() ? "" : ",");
+  }
+  printf("]}\n");
+
+  return unreadable == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "cutemodel/cute_model.h"
+#include "model/model_reader.h"
+#include "model/ssd_model.h"
+#include "profile/clock.h"
+#include "platform/emscripten_compat.h"
+#include "sample_jpg.h"
+
+namespace {
+
+using Model = vc::BlazeFaceShortRange;
+
+// Largest output difference allowed, relative to the largest output
+constexpr double kMaxRelativeError = 1e-4;
+constexpr int kFrames = 100;
+
+// Largest difference of the outputs of both models on one 0..255 input, relative to the largest output
+double CompareOutputs(cute::CuteModel& normalized, cute::CuteModel& folded, const cv::Mat& input) {
+  cv::Mat normalized_input, raw_input;
+  input.convertTo(normalized_input, CV_32F, Model::kInputScale, Model::kInputOffset);
+  input.convertTo(raw_input, CV_32F);
+  normalized.setInput(normalized_input.data);
+  folded.setInput(raw_input.data);
+  normalized.invoke();
+  folded.invoke();
+
+  double error = 0;
+  for (int i = 0, count = static_cast<int>(normalized.outputTensorCount()); i < count; ++i) {
+    auto a = normalized.getOutput<float>(i), b = folded.getOutput<float>(i);
+    double diff = 0, range = 1;
+    for (size_t j = 0; j < a.size(); ++j) {
+      diff = std::max(diff, static_cast<double>(std::abs(a[j] - b[j])));
+      range = std::max(range, static_cast<double>(std::abs(a[j])));
+    }
+    error = std::max(error, diff / range);
+  }
+  return error;
+}
+
+// Operators of the execution plan that run as builtin kernels instead of in a delegate partition
+std::string UndelegatedNodes(const cute::CuteModel& model) {
+  std::string names;
+  for (const auto& name : model.executionPlan()) {
+    if (name.find("Delegate") != std::string::npos)
+      continue;
+    names += (names.empty() ? "" : " ") + name;
+  }
+  return names.empty() ? "none" : names;
+}
+
+// Mean ms of the normalize stage and of the whole Detect on the Image path
+std::pair<double, double> TimeImagePath(vc::BlazeFaceWrapper& wrapper, const cv::Mat& image) {
+  wrapper.Detect(image, 0);
+  double normalize_ms = 0, total_ms = 0;
+  for (int i = 0; i < kFrames; ++i) {
+    wrapper.Detect(image, 0);
+    normalize_ms += wrapper.LastStageTimes()[vc::Stage::kNormalize];
+    total_ms += wrapper.LastStageTimes().total();
+  }
+  return {normalize_ms / kFrames, total_ms / kFrames};
+}
+
+} // namespace
+
+// Checks that the model with the input normalization folded into its first convolution
+// (ModelReader::ReadBlazeFaceModelRawInput) gives the outputs of the embedded model, on the sample
+// image and on noise and flat inputs that exercise the padded borders, then compares the detections
+// and the Image path time of both. Also lists the operators each model runs outside the delegate,
+// the folded one adds its PADV2 there. Returns 1 if the outputs differ.
+EMSCRIPTEN_KEEPALIVE
+int main() {
+  auto original = vc::ModelReader::ReadBlazeFaceModel();
+  auto start_time = vc::NowMs();
+  auto raw = vc::ModelReader::ReadBlazeFaceModelRawInput();
+  auto fold_ms = vc::NowMs() - start_time;
+  if (raw.size == 0) {
+    printf("FAIL : the model could not be folded\n");
+    return 1;
+  }
+  printf("Fold : %.3f ms, %u -> %u bytes\n", fold_ms, original.size, raw.size);
+
+  cute::CuteModel normalized, folded;
+  normalized.loadBuffer(original.byte, original.size).setNumThreads(1).build();
+  folded.loadBuffer(raw.byte, raw.size).setNumThreads(1).build();
+  printf("Outside the delegate : %s -> %s\n", UndelegatedNodes(normalized).c_str(), UndelegatedNodes(folded).c_str());
+
+  std::vector<unsigned char> sample_image(elon_jpg, elon_jpg + elon_jpg_len);
+  auto image = cv::imdecode(sample_image, cv::IMREAD_COLOR);
+
+  std::vector<cv::Mat> inputs;
+  cv::Mat resized;
+  cv::resize(image, resized, {Model::kInputWidth, Model::kInputHeight});
+  inputs.push_back(resized);
+  cv::Mat noise(Model::kInputHeight, Model::kInputWidth, CV_8UC3);
+  cv::randu(noise, 0, 256);
+  inputs.push_back(noise);
+  inputs.emplace_back(Model::kInputHeight, Model::kInputWidth, CV_8UC3, cv::Scalar::all(0));
+  inputs.emplace_back(Model::kInputHeight, Model::kInputWidth, CV_8UC3, cv::Scalar::all(255));
+
+  double error = 0;
+  for (const auto& input : inputs)
+    error = std::max(error, CompareOutputs(normalized, folded, input));
+  printf("Output error : %g (max %g)\n", error, kMaxRelativeError);
+
+  vc::BlazeFaceWrapper normalized_wrapper(1);
+  vc::BlazeFaceWrapper folded_wrapper(raw.byte, raw.size, 1, true);
+  auto a = normalized_wrapper.Detect(image, 0), b = folded_wrapper.Detect(image, 0);
+  auto same_face = a.roi == b.roi && std::abs(a.score - b.score) < 1e-4;
+  printf("Face : %s, score %f / %f\n", same_face ? "same" : "different", a.score, b.score);
+
+  auto [normalize_ms, total_ms] = TimeImagePath(normalized_wrapper, image);
+  auto [raw_normalize_ms, raw_total_ms] = TimeImagePath(folded_wrapper, image);
+  printf("Normalize ms : %.3f -> %.3f, Detect ms : %.3f -> %.3f\n", normalize_ms, raw_normalize_ms, total_ms,
+         raw_total_ms);
+
+  auto ok = error <= kMaxRelativeError && same_face;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
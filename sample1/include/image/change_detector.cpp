@@ -0,0 +1,107 @@
+#include "image/change_detector.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "image/lite_simd.h"
+
+namespace vc {
+
+namespace {
+
+// Margin added on every side of the reference face, as a fraction of its size
+constexpr float kRoiMargin = 0.5f;
+
+constexpr int kTaps = 2 * ChangeDetector::kThumbSize;
+
+uint32_t SumAbsDiff(const uint8_t* a, const uint8_t* b, int size) {
+  uint32_t sum = 0;
+  int i = 0;
+#ifdef VC_LITE_SIMD
+  using namespace lite::simd;
+  while (i + 16 <= size) {
+    u16x16 acc{};
+    for (int end = std::min(size - 15, i + 256 * 16); i < end; i += 16)
+      AddAbsDiff(acc, LoadU8x16(a + i), LoadU8x16(b + i));
+    for (int lane = 0; lane < 16; ++lane)
+      sum += acc[lane];
+  }
+#endif
+  for (; i < size; ++i)
+    sum += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+  return sum;
+}
+
+// Sample positions that split [begin, end) into kTaps equal parts, at their centers
+void Taps(int begin, int end, int* taps) {
+  const auto span = end - begin;
+  for (int i = 0; i < kTaps; ++i)
+    taps[i] = begin + (2 * i + 1) * span / (2 * kTaps);
+}
+
+} // namespace
+
+void ChangeDetector::SetReference(const ImageDesc& image, const std::vector<int>& roi) {
+  has_reference = false;
+  if (image.empty())
+    return;
+
+  format = image.format;
+  width = image.width;
+  height = image.height;
+  left = 0, top = 0, right = width, bottom = height;
+
+  if (roi.size() == 4 && roi[2] > roi[0] && roi[3] > roi[1]) {
+    auto margin_x = static_cast<int>(static_cast<float>(roi[2] - roi[0]) * kRoiMargin);
+    auto margin_y = static_cast<int>(static_cast<float>(roi[3] - roi[1]) * kRoiMargin);
+    auto l = std::max(roi[0] - margin_x, 0), t = std::max(roi[1] - margin_y, 0);
+    auto r = std::min(roi[2] + margin_x, width), b = std::min(roi[3] + margin_y, height);
+    // A face outside of the frame compares the whole frame
+    if (r > l && b > t)
+      left = l, top = t, right = r, bottom = b;
+  }
+
+  Reduce(image, reference);
+  has_reference = true;
+}
+
+bool ChangeDetector::Unchanged(const ImageDesc& image) {
+  last_difference = -1;
+  if (!has_reference || image.empty() || image.format != format || image.width != width || image.height != height)
+    return false;
+
+  Reduce(image, current);
+  auto sad = SumAbsDiff(reference.data(), current.data(), static_cast<int>(current.size()));
+  last_difference = static_cast<float>(sad) / static_cast<float>(current.size());
+  return last_difference < threshold;
+}
+
+void ChangeDetector::Reduce(const ImageDesc& image, Thumbnail& dst) const {
+  int xs[kTaps], ys[kTaps];
+  Taps(left, right, xs);
+  Taps(top, bottom, ys);
+
+  // Luma of one tap: the Y plane, or BT.601 weights of the packed channels
+  const auto bpp = BytesPerPixel(image.format);
+  const auto yuv = IsYUV(image.format);
+  const auto r = image.format == PixelFormat::kBGRA || image.format == PixelFormat::kBGR ? 2 : 0;
+  const auto b = 2 - r;
+  for (auto& x : xs) x *= bpp;
+
+  auto luma = [&](const uint8_t* row, int x) -> int {
+    const auto* p = row + x;
+    return yuv ? p[0] : (77 * p[r] + 150 * p[1] + 29 * p[b] + 128) >> 8;
+  };
+
+  for (int cy = 0; cy < kThumbSize; ++cy) {
+    const auto* row0 = image.planes[0] + static_cast<size_t>(ys[2 * cy]) * image.strides[0];
+    const auto* row1 = image.planes[0] + static_cast<size_t>(ys[2 * cy + 1]) * image.strides[0];
+    auto* out = dst.data() + cy * kThumbSize;
+    for (int cx = 0; cx < kThumbSize; ++cx) {
+      auto x0 = xs[2 * cx], x1 = xs[2 * cx + 1];
+      out[cx] = static_cast<uint8_t>((luma(row0, x0) + luma(row0, x1) + luma(row1, x0) + luma(row1, x1) + 2) >> 2);
+    }
+  }
+}
+
+} // namespace vc
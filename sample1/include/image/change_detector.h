@@ -0,0 +1,60 @@
+#ifndef WASMSAMPLE_IMAGE_CHANGE_DETECTOR_H_
+#define WASMSAMPLE_IMAGE_CHANGE_DETECTOR_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "image/image_desc.h"
+
+namespace vc {
+
+// Tells whether a frame differs from a reference frame, for skipping inference on static scenes.
+//
+// Both frames are reduced to a kThumbSize x kThumbSize luma thumbnail of the same region, the face
+// of the reference with a margin around it, or the whole frame without one. The frame is unchanged
+// while the mean absolute difference of the thumbnails stays below the threshold, in 8-bit luma
+// levels. The comparison is always against the reference, so slow drift still adds up to a change.
+//
+// A thumbnail reads 4 luma samples per cell, about 4k pixels whatever the frame size.
+class ChangeDetector {
+ public:
+  static constexpr int kThumbSize = 32;
+  // Above the noise of a still webcam frame, below a head turn or a hand in front of the face
+  static constexpr float kDefaultThreshold = 3.f;
+
+  explicit ChangeDetector(float threshold = kDefaultThreshold) : threshold(threshold) {}
+
+  void SetThreshold(float threshold) { this->threshold = threshold; }
+  float Threshold() const { return threshold; }
+
+  // Takes image as the reference. roi is the face in image (left, top, right, bottom), empty if there is none.
+  void SetReference(const ImageDesc& image, const std::vector<int>& roi);
+  void Reset() { has_reference = false; }
+
+  // False without a reference, or when the format or size differs from it
+  bool Unchanged(const ImageDesc& image);
+
+  // Mean absolute difference of the last Unchanged call, -1 if it did not compare
+  float LastDifference() const { return last_difference; }
+
+ private:
+  using Thumbnail = std::array<uint8_t, kThumbSize * kThumbSize>;
+
+  void Reduce(const ImageDesc& image, Thumbnail& dst) const;
+
+  float threshold;
+  bool has_reference = false;
+  PixelFormat format = PixelFormat::kRGBA;
+  int width = 0;
+  int height = 0;
+  // Region of the thumbnails in frame pixels, [left, right) x [top, bottom)
+  int left = 0, top = 0, right = 0, bottom = 0;
+  Thumbnail reference{};
+  Thumbnail current{};
+  float last_difference = -1;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_IMAGE_CHANGE_DETECTOR_H_
@@ -0,0 +1,33 @@
+#ifndef WASMSAMPLE_IMAGE_CV_COMPAT_H_
+#define WASMSAMPLE_IMAGE_CV_COMPAT_H_
+
+// vc::cvx is OpenCV, or the built-in lite image module when building with WASMSAMPLE_NO_OPENCV
+// (CMake option WITH_OPENCV=OFF). Code using cvx:: and the CV_* type macros builds either way.
+
+#ifdef WASMSAMPLE_NO_OPENCV
+
+#include "image/lite_imgproc.h"
+#include "image/lite_mat.h"
+
+#define CV_8U vc::lite::kDepth8U
+#define CV_32F vc::lite::kDepth32F
+#define CV_64F vc::lite::kDepth64F
+#define CV_8UC3 vc::lite::kType8UC3
+#define CV_8UC4 vc::lite::kType8UC4
+#define CV_32FC3 vc::lite::kType32FC3
+
+namespace vc {
+namespace cvx = lite;
+} // namespace vc
+
+#else
+
+#include "opencv2/opencv.hpp"
+
+namespace vc {
+namespace cvx = ::cv;
+} // namespace vc
+
+#endif
+
+#endif //WASMSAMPLE_IMAGE_CV_COMPAT_H_
@@ -0,0 +1,32 @@
+#ifndef WASMSAMPLE_IMAGE_FUSED_SAMPLER_H_
+#define WASMSAMPLE_IMAGE_FUSED_SAMPLER_H_
+
+#include "image/image_desc.h"
+
+namespace vc {
+
+// Maps a destination pixel (x, y) to the source coordinate
+// (m[0] * x + m[1] * y + m[2], m[3] * x + m[4] * y + m[5]).
+struct AffineMap {
+  float m[6] = {1, 0, 0, 0, 1, 0};
+};
+
+// Resize, letterbox, rotation, color conversion and normalization in a single pass.
+//
+// Every destination pixel is mapped through dst_to_src and sampled bilinearly from src, YUV formats
+// are converted to RGB (BT.601, video range) after sampling, so only dst_width * dst_height pixels
+// are ever converted. Writes interleaved RGB floats (value * alpha + beta). Samples falling outside
+// of src are treated as black, like the constant border of the letterbox.
+void SampleRGB(const ImageDesc& src, const AffineMap& dst_to_src,
+               float* dst, int dst_width, int dst_height,
+               float alpha, float beta);
+
+// Rows [row_begin, row_end) of the SampleRGB output, for splitting it into bands. dst is the
+// whole output.
+void SampleRGBRows(const ImageDesc& src, const AffineMap& dst_to_src,
+                   float* dst, int dst_width, int row_begin, int row_end,
+                   float alpha, float beta);
+
+} // namespace vc
+
+#endif //WASMSAMPLE_IMAGE_FUSED_SAMPLER_H_
@@ -0,0 +1,128 @@
+#include "image/jpeg_decoder.h"
+
+#include <fstream>
+#include <utility>
+
+namespace vc {
+
+namespace {
+
+int ReadUint16(const unsigned char* p) {
+  return (p[0] << 8) | p[1];
+}
+
+// Start of frame markers, all but DHT (C4), JPG (C8) and DAC (CC)
+bool IsStartOfFrame(unsigned char marker) {
+  return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+}
+
+int ReducedColorFlag(int denominator) {
+  switch (denominator) {
+    case 8: return cv::IMREAD_REDUCED_COLOR_8;
+    case 4: return cv::IMREAD_REDUCED_COLOR_4;
+    case 2: return cv::IMREAD_REDUCED_COLOR_2;
+    default: return cv::IMREAD_COLOR;
+  }
+}
+
+} // namespace
+
+bool ReadJpegInfo(const unsigned char* data, size_t size, JpegInfo& info) {
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+    return false;
+
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF)
+      return false;
+    auto marker = data[pos + 1];
+    if (marker == 0xFF) {  // fill byte
+      ++pos;
+      continue;
+    }
+    if (marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7)) {  // no length
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA)  // end of image or start of scan before any frame
+      return false;
+
+    auto length = static_cast<size_t>(ReadUint16(data + pos + 2));
+    if (length < 2 || pos + 2 + length > size)
+      return false;
+    if (IsStartOfFrame(marker)) {
+      if (length < 8)
+        return false;
+      const auto* frame = data + pos + 4;  // precision, height, width, components
+      info.height = ReadUint16(frame + 1);
+      info.width = ReadUint16(frame + 3);
+      info.components = frame[5];
+      return info.width > 0 && info.height > 0;
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+int JpegScaleDenominator(int width, int height, int target_width, int target_height) {
+  // The letterbox scales the image by min(target / size), the decoded image covers it while
+  // 1 / denominator >= that scale
+  for (int denominator = 8; denominator > 1; denominator /= 2) {
+    if (denominator * target_width <= width || denominator * target_height <= height)
+      return denominator;
+  }
+  return 1;
+}
+
+JpegDecoder::JpegDecoder(int target_width, int target_height)
+  : target_width(target_width), target_height(target_height) {}
+
+const cv::Mat& JpegDecoder::Decode(const unsigned char* data, size_t size) {
+  const cv::Mat buffer(1, static_cast<int>(size), CV_8U, const_cast<unsigned char*>(data));
+
+  JpegInfo info;
+  if (!ReadJpegInfo(data, size, info)) {
+    image = cv::imdecode(buffer, cv::IMREAD_COLOR);
+    width = image.cols;
+    height = image.rows;
+    return image;
+  }
+
+  width = info.width;
+  height = info.height;
+  auto denominator = JpegScaleDenominator(width, height, target_width, target_height);
+
+  // imdecode reallocates image only if the decoded size changes, and leaves it untouched if the
+  // header cannot be read, so a failure shows as an unexpected size. EXIF orientation may swap it.
+  cv::imdecode(buffer, ReducedColorFlag(denominator), &image);
+  auto expected_width = (width + denominator - 1) / denominator;
+  auto expected_height = (height + denominator - 1) / denominator;
+  if (image.cols == expected_height && image.rows == expected_width && expected_width != expected_height)
+    std::swap(width, height);
+  else if (image.cols != expected_width || image.rows != expected_height)
+    image.release();
+  return image;
+}
+
+const cv::Mat& JpegDecoder::Decode(const std::vector<unsigned char>& data) {
+  return Decode(data.data(), data.size());
+}
+
+const cv::Mat& JpegDecoder::DecodeFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    image.release();
+    width = height = 0;
+    return image;
+  }
+  file_buffer.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(file_buffer.data()), static_cast<std::streamsize>(file_buffer.size()));
+  return Decode(file_buffer);
+}
+
+double JpegDecoder::Scale() const {
+  return image.empty() ? 1.0 : static_cast<double>(width) / image.cols;
+}
+
+} // namespace vc
@@ -0,0 +1,57 @@
+#ifndef WASMSAMPLE_IMAGE_JPEG_DECODER_H_
+#define WASMSAMPLE_IMAGE_JPEG_DECODER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+namespace vc {
+
+// Size of a JPEG, read from its SOF marker without decoding
+struct JpegInfo {
+  int width = 0;
+  int height = 0;
+  int components = 0;
+};
+
+// False if data is not a JPEG or has no frame header before the first scan
+bool ReadJpegInfo(const unsigned char* data, size_t size, JpegInfo& info);
+
+// Largest libjpeg scale denominator (8, 4, 2 or 1) whose output still fills a letterbox of
+// target_width x target_height, so the decoded image is never upsampled by the detector
+int JpegScaleDenominator(int width, int height, int target_width, int target_height);
+
+// Decodes images for a detector with a target_width x target_height input.
+//
+// JPEGs are scaled by 1/2, 1/4 or 1/8 in the DCT domain by libjpeg-turbo (JpegScaleDenominator),
+// which decodes a fraction of the coefficients and writes a fraction of the pixels. The BGR output
+// goes to a buffer reused across calls. Other formats are decoded at full size.
+class JpegDecoder {
+ public:
+  JpegDecoder(int target_width, int target_height);
+
+  // Empty if the data cannot be decoded. Valid until the next call.
+  const cv::Mat& Decode(const unsigned char* data, size_t size);
+  const cv::Mat& Decode(const std::vector<unsigned char>& data);
+  const cv::Mat& DecodeFile(const std::string& path);
+
+  // Of the last decoded image: its size before scaling, and original / decoded width for mapping
+  // detections back
+  int Width() const { return width; }
+  int Height() const { return height; }
+  double Scale() const;
+
+ private:
+  int target_width;
+  int target_height;
+  int width = 0;
+  int height = 0;
+  cv::Mat image;
+  std::vector<unsigned char> file_buffer;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_IMAGE_JPEG_DECODER_H_
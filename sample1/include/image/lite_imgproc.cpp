@@ -0,0 +1,324 @@
+#include "image/lite_imgproc.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "image/lite_simd.h"
+
+namespace vc {
+namespace lite {
+
+namespace {
+
+template<typename T>
+T Round(float v);
+
+template<> uint8_t Round<uint8_t>(float v) {
+  return static_cast<uint8_t>(std::min(std::max(static_cast<int>(v + 0.5f), 0), 255));
+}
+template<> float Round<float>(float v) { return v; }
+
+//
+// cvtColor
+//
+template<int scn, int dcn, bool swap>
+void ConvertColorRow(const uint8_t* src, uint8_t* dst, int width) {
+  for (int x = 0; x < width; ++x, src += scn, dst += dcn) {
+    uint8_t c0 = src[0], c1 = src[1], c2 = src[2];
+    uint8_t alpha = scn == 4 ? src[3] : 255;
+    dst[0] = swap ? c2 : c0;
+    dst[1] = c1;
+    dst[2] = swap ? c0 : c2;
+    if (dcn == 4) dst[3] = alpha;
+  }
+}
+
+template<int scn, int dcn, bool swap>
+void ConvertColor(const Mat& src, Mat& dst) {
+  for (int y = 0; y < src.rows; ++y)
+    ConvertColorRow<scn, dcn, swap>(src.ptr<uint8_t>(y), dst.ptr<uint8_t>(y), src.cols);
+}
+
+//
+// resize
+//
+struct LinearTap {
+  int i0;
+  int i1;
+  float a;  // weight of i1
+};
+
+// Pixel centers aligned and edges clamped like OpenCV's INTER_LINEAR
+std::vector<LinearTap> LinearTaps(int src_size, int dst_size, double scale) {
+  std::vector<LinearTap> taps(dst_size);
+  for (int d = 0; d < dst_size; ++d) {
+    auto f = (d + 0.5) * scale - 0.5;
+    auto s = static_cast<int>(std::floor(f));
+    f -= s;
+    if (s < 0) {
+      s = 0;
+      f = 0;
+    }
+    if (s >= src_size - 1) {
+      s = src_size - 1;
+      f = 0;
+    }
+    taps[d] = {s, std::min(s + 1, src_size - 1), static_cast<float>(f)};
+  }
+  return taps;
+}
+
+template<typename T>
+void HorizontalPass(const T* src, float* dst, const std::vector<LinearTap>& taps, int cn) {
+  for (size_t x = 0; x < taps.size(); ++x) {
+    const auto* p0 = src + taps[x].i0 * cn;
+    const auto* p1 = src + taps[x].i1 * cn;
+    auto a = taps[x].a;
+    for (int c = 0; c < cn; ++c)
+      dst[x * cn + c] = p0[c] + (static_cast<float>(p1[c]) - p0[c]) * a;
+  }
+}
+
+template<typename T>
+void VerticalPass(const float* row0, const float* row1, float a, T* dst, int n) {
+  int x = 0;
+#ifdef VC_LITE_SIMD
+  const auto va = simd::Splat(a);
+  for (; x + 4 <= n; x += 4) {
+    auto r0 = simd::Load(row0 + x);
+    auto v = r0 + (simd::Load(row1 + x) - r0) * va;
+    if constexpr (std::is_same<T, uint8_t>::value) simd::StoreU8(dst + x, v);
+    else simd::Store(dst + x, v);
+  }
+#endif
+  for (; x < n; ++x)
+    dst[x] = Round<T>(row0[x] + (row1[x] - row0[x]) * a);
+}
+
+template<typename T>
+void ResizeLinear(const Mat& src, Mat& dst) {
+  auto cn = src.channels();
+  auto x_taps = LinearTaps(src.cols, dst.cols, static_cast<double>(src.cols) / dst.cols);
+  auto y_taps = LinearTaps(src.rows, dst.rows, static_cast<double>(src.rows) / dst.rows);
+
+  // Horizontally interpolated source rows, reused while consecutive output rows share them
+  auto n = dst.cols * cn;
+  std::vector<float> rows(2 * n);
+  float* row[2] = {rows.data(), rows.data() + n};
+  int row_index[2] = {-1, -1};
+
+  for (int y = 0; y < dst.rows; ++y) {
+    const auto& tap = y_taps[y];
+    if (row_index[0] != tap.i0 && row_index[1] == tap.i0) {
+      std::swap(row[0], row[1]);
+      std::swap(row_index[0], row_index[1]);
+    }
+    if (row_index[0] != tap.i0) {
+      HorizontalPass(src.ptr<T>(tap.i0), row[0], x_taps, cn);
+      row_index[0] = tap.i0;
+    }
+    if (row_index[1] != tap.i1) {
+      HorizontalPass(src.ptr<T>(tap.i1), row[1], x_taps, cn);
+      row_index[1] = tap.i1;
+    }
+    VerticalPass(row[0], row[1], tap.a, dst.ptr<T>(y), n);
+  }
+}
+
+//
+// copyMakeBorder
+//
+std::vector<unsigned char> BorderPixel(int type, const Scalar& value) {
+  auto depth = TypeDepth(type), cn = TypeChannels(type);
+  std::vector<unsigned char> pixel;
+  for (int c = 0; c < cn; ++c) {
+    auto v = value.val[std::min(c, 3)];
+    if (depth == kDepth8U) {
+      auto u = static_cast<uint8_t>(std::min(std::max(std::lround(v), 0L), 255L));
+      pixel.push_back(u);
+    } else if (depth == kDepth32F) {
+      auto f = static_cast<float>(v);
+      auto bytes = reinterpret_cast<const unsigned char*>(&f);
+      pixel.insert(pixel.end(), bytes, bytes + sizeof(f));
+    } else {
+      auto bytes = reinterpret_cast<const unsigned char*>(&v);
+      pixel.insert(pixel.end(), bytes, bytes + sizeof(v));
+    }
+  }
+  return pixel;
+}
+
+void FillPixels(unsigned char* dst, const std::vector<unsigned char>& pixel, int count) {
+  for (int i = 0; i < count; ++i, dst += pixel.size())
+    std::memcpy(dst, pixel.data(), pixel.size());
+}
+
+//
+// warpAffine
+//
+template<typename T>
+void WarpLinear(const Mat& src, Mat& dst, const double* m, const Scalar& border) {
+  auto cn = src.channels();
+  float border_value[4];
+  for (int c = 0; c < 4; ++c) border_value[c] = static_cast<float>(border.val[c]);
+
+  auto fetch = [&](int x, int y, int c) -> float {
+    if (x < 0 || y < 0 || x >= src.cols || y >= src.rows)
+      return border_value[std::min(c, 3)];
+    return src.ptr<T>(y)[x * cn + c];
+  };
+
+  for (int y = 0; y < dst.rows; ++y) {
+    auto* d = dst.ptr<T>(y);
+    auto sx = m[1] * y + m[2];
+    auto sy = m[4] * y + m[5];
+    for (int x = 0; x < dst.cols; ++x, sx += m[0], sy += m[3], d += cn) {
+      auto fx = static_cast<float>(sx), fy = static_cast<float>(sy);
+      auto x0 = static_cast<int>(std::floor(fx)), y0 = static_cast<int>(std::floor(fy));
+      auto ax = fx - x0, ay = fy - y0;
+
+      // Fast path when all four taps are inside
+      if (x0 >= 0 && y0 >= 0 && x0 + 1 < src.cols && y0 + 1 < src.rows) {
+        const auto* p0 = src.ptr<T>(y0) + x0 * cn;
+        const auto* p1 = src.ptr<T>(y0 + 1) + x0 * cn;
+        for (int c = 0; c < cn; ++c) {
+          auto top = p0[c] + (static_cast<float>(p0[c + cn]) - p0[c]) * ax;
+          auto bottom = p1[c] + (static_cast<float>(p1[c + cn]) - p1[c]) * ax;
+          d[c] = Round<T>(top + (bottom - top) * ay);
+        }
+      } else if (x0 < -1 || y0 < -1 || x0 >= src.cols || y0 >= src.rows) {
+        for (int c = 0; c < cn; ++c) d[c] = Round<T>(border_value[std::min(c, 3)]);
+      } else {
+        for (int c = 0; c < cn; ++c) {
+          auto top = fetch(x0, y0, c) + (fetch(x0 + 1, y0, c) - fetch(x0, y0, c)) * ax;
+          auto bottom = fetch(x0, y0 + 1, c) + (fetch(x0 + 1, y0 + 1, c) - fetch(x0, y0 + 1, c)) * ax;
+          d[c] = Round<T>(top + (bottom - top) * ay);
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+void cvtColor(const Mat& src_, Mat& dst, int code) {
+  assert(src_.depth() == kDepth8U);
+  Mat src = src_;
+
+  int scn = 3, dcn = 3;
+  switch (code) {
+    case COLOR_BGR2BGRA: case COLOR_BGR2RGBA: dcn = 4; break;
+    case COLOR_BGRA2BGR: case COLOR_BGRA2RGB: scn = 4; break;
+    case COLOR_BGRA2RGBA: scn = dcn = 4; break;
+    case COLOR_BGR2RGB: break;
+    default: assert(((void)"Unsupported color conversion", false));
+  }
+  assert(src.channels() == scn);
+
+  dst.create(src.rows, src.cols, MakeType(kDepth8U, dcn));
+  switch (code) {
+    case COLOR_BGR2BGRA: ConvertColor<3, 4, false>(src, dst); break;
+    case COLOR_BGRA2BGR: ConvertColor<4, 3, false>(src, dst); break;
+    case COLOR_BGR2RGBA: ConvertColor<3, 4, true>(src, dst); break;
+    case COLOR_BGRA2RGB: ConvertColor<4, 3, true>(src, dst); break;
+    case COLOR_BGR2RGB: ConvertColor<3, 3, true>(src, dst); break;
+    case COLOR_BGRA2RGBA: ConvertColor<4, 4, true>(src, dst); break;
+  }
+}
+
+void resize(const Mat& src_, Mat& dst, Size dsize, double fx, double fy, int interpolation) {
+  assert(interpolation == INTER_LINEAR);
+  Mat src = src_;
+  if (dsize.area() == 0)
+    dsize = {static_cast<int>(std::round(src.cols * fx)), static_cast<int>(std::round(src.rows * fy))};
+
+  if (dst.data == src.data) dst = Mat();
+  dst.create(dsize, src.type());
+  if (src.size() == dsize) {
+    src.copyTo(dst);
+    return;
+  }
+
+  switch (src.depth()) {
+    case kDepth8U: ResizeLinear<uint8_t>(src, dst); break;
+    case kDepth32F: ResizeLinear<float>(src, dst); break;
+    default: assert(((void)"Unsupported depth", false));
+  }
+}
+
+void copyMakeBorder(const Mat& src_, Mat& dst, int top, int bottom, int left, int right,
+                    int borderType, const Scalar& value) {
+  assert(borderType == BORDER_CONSTANT);
+  Mat src = src_;
+
+  if (dst.data == src.data) dst = Mat();
+  dst.create(src.rows + top + bottom, src.cols + left + right, src.type());
+
+  auto pixel = BorderPixel(src.type(), value);
+  auto elem_size = src.elemSize();
+  for (int y = 0; y < dst.rows; ++y) {
+    auto* d = dst.ptr(y);
+    auto sy = y - top;
+    if (sy < 0 || sy >= src.rows) {
+      FillPixels(d, pixel, dst.cols);
+      continue;
+    }
+    FillPixels(d, pixel, left);
+    std::memcpy(d + left * elem_size, src.ptr(sy), src.cols * elem_size);
+    FillPixels(d + (left + src.cols) * elem_size, pixel, right);
+  }
+}
+
+void warpAffine(const Mat& src_, Mat& dst, const Mat& M, Size dsize, int flags,
+                int borderMode, const Scalar& borderValue) {
+  assert(borderMode == BORDER_CONSTANT);
+  assert(M.rows == 2 && M.cols == 3);
+  Mat src = src_;
+
+  double m[6];
+  for (int i = 0; i < 6; ++i)
+    m[i] = M.depth() == kDepth64F ? M.at<double>(i / 3, i % 3) : M.at<float>(i / 3, i % 3);
+
+  // Walk the destination, so map dst -> src
+  if (!(flags & WARP_INVERSE_MAP)) {
+    auto det = m[0] * m[4] - m[1] * m[3];
+    det = det != 0 ? 1. / det : 0.;
+    double a11 = m[4] * det, a12 = -m[1] * det, a21 = -m[3] * det, a22 = m[0] * det;
+    double b1 = -a11 * m[2] - a12 * m[5], b2 = -a21 * m[2] - a22 * m[5];
+    m[0] = a11; m[1] = a12; m[2] = b1;
+    m[3] = a21; m[4] = a22; m[5] = b2;
+  }
+
+  if (dst.data == src.data) dst = Mat();
+  dst.create(dsize, src.type());
+
+  switch (src.depth()) {
+    case kDepth8U: WarpLinear<uint8_t>(src, dst, m, borderValue); break;
+    case kDepth32F: WarpLinear<float>(src, dst, m, borderValue); break;
+    default: assert(((void)"Unsupported depth", false));
+  }
+}
+
+Mat getRotationMatrix2D(Point2f center, double angle, double scale) {
+  angle *= 3.14159265358979323846 / 180;
+  auto alpha = std::cos(angle) * scale;
+  auto beta = std::sin(angle) * scale;
+
+  Mat M(2, 3, kType64FC1);
+  auto* m = M.ptr<double>(0);
+  auto* n = M.ptr<double>(1);
+  m[0] = alpha;
+  m[1] = beta;
+  m[2] = (1 - alpha) * center.x - beta * center.y;
+  n[0] = -beta;
+  n[1] = alpha;
+  n[2] = beta * center.x + (1 - alpha) * center.y;
+  return M;
+}
+
+} // namespace lite
+} // namespace vc
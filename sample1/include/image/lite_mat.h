@@ -0,0 +1,151 @@
+#ifndef WASMSAMPLE_IMAGE_LITE_MAT_H_
+#define WASMSAMPLE_IMAGE_LITE_MAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace vc {
+namespace lite {
+
+// Minimal stand-in for the parts of OpenCV's core module this project uses, so the detector
+// builds without OpenCV (see image/cv_compat.h). Names, type codes and semantics follow OpenCV,
+// code written against this subset compiles against both. The CV_* type macros are only defined
+// by cv_compat.h, this header can be included next to OpenCV.
+
+enum {
+  kDepth8U = 0,
+  kDepth32F = 5,
+  kDepth64F = 6,
+};
+
+constexpr int MakeType(int depth, int channels) { return depth + ((channels - 1) << 3); }
+constexpr int TypeDepth(int type) { return type & 7; }
+constexpr int TypeChannels(int type) { return (type >> 3) + 1; }
+
+enum {
+  kType8UC1 = MakeType(kDepth8U, 1),
+  kType8UC3 = MakeType(kDepth8U, 3),
+  kType8UC4 = MakeType(kDepth8U, 4),
+  kType32FC1 = MakeType(kDepth32F, 1),
+  kType32FC3 = MakeType(kDepth32F, 3),
+  kType64FC1 = MakeType(kDepth64F, 1),
+};
+
+template<typename T>
+struct Point_ {
+  T x = 0;
+  T y = 0;
+
+  Point_() = default;
+  Point_(T x, T y) : x(x), y(y) {}
+};
+
+using Point = Point_<int>;
+using Point2f = Point_<float>;
+
+struct Point3f {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+
+  Point3f() = default;
+  Point3f(float x, float y, float z) : x(x), y(y), z(z) {}
+};
+
+struct Size {
+  int width = 0;
+  int height = 0;
+
+  Size() = default;
+  Size(int width, int height) : width(width), height(height) {}
+
+  int area() const { return width * height; }
+  bool operator == (const Size& other) const { return width == other.width && height == other.height; }
+  bool operator != (const Size& other) const { return !(*this == other); }
+};
+
+struct Rect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+
+  Rect() = default;
+  Rect(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+  Rect(Point origin, Size size) : x(origin.x), y(origin.y), width(size.width), height(size.height) {}
+
+  Point tl() const { return {x, y}; }
+  Size size() const { return {width, height}; }
+  bool empty() const { return width <= 0 || height <= 0; }
+};
+
+Rect operator & (const Rect& a, const Rect& b);
+inline Rect operator - (const Rect& rect, const Point& offset) {
+  return {rect.x - offset.x, rect.y - offset.y, rect.width, rect.height};
+}
+
+struct Scalar {
+  double val[4] = {0, 0, 0, 0};
+
+  Scalar() = default;
+  Scalar(double v0, double v1 = 0, double v2 = 0, double v3 = 0) : val{v0, v1, v2, v3} {}
+};
+
+// 2D, reference counted image like cv::Mat. Copies share the pixels, clone() copies them.
+// Either owns its buffer or views external memory (which must outlive it).
+class Mat {
+ public:
+  Mat() = default;
+  Mat(int rows, int cols, int type);
+  Mat(Size size, int type) : Mat(size.height, size.width, type) {}
+  Mat(int rows, int cols, int type, void* data, size_t step = 0);
+  Mat(Size size, int type, void* data, size_t step = 0) : Mat(size.height, size.width, type, data, step) {}
+
+  // View of a region, shares the pixels
+  Mat operator () (const Rect& roi) const;
+
+  static Mat zeros(Size size, int type);
+  static Mat zeros(int rows, int cols, int type) { return zeros(Size(cols, rows), type); }
+
+  // Reallocates unless the image already has this size and type
+  void create(int rows, int cols, int type);
+  void create(Size size, int type) { create(size.height, size.width, type); }
+
+  Mat clone() const;
+  void copyTo(Mat& dst) const;
+  void copyTo(Mat&& dst) const { copyTo(dst); }  // e.g. into a region view
+
+  // dst = src * alpha + beta, saturated to the destination depth (8U, 32F or 64F)
+  void convertTo(Mat& dst, int rtype, double alpha = 1, double beta = 0) const;
+
+  bool empty() const { return data == nullptr || rows == 0 || cols == 0; }
+  int type() const { return type_; }
+  int depth() const { return TypeDepth(type_); }
+  int channels() const { return TypeChannels(type_); }
+  size_t elemSize() const;
+  size_t total() const { return static_cast<size_t>(rows) * cols; }
+  bool isContinuous() const { return step == cols * elemSize(); }
+  Size size() const { return {cols, rows}; }
+
+  template<typename T = unsigned char> T* ptr(int y = 0) { return reinterpret_cast<T*>(data + y * step); }
+  template<typename T = unsigned char> const T* ptr(int y = 0) const {
+    return reinterpret_cast<const T*>(data + y * step);
+  }
+  template<typename T> T& at(int y, int x) { return ptr<T>(y)[x]; }
+  template<typename T> const T& at(int y, int x) const { return ptr<T>(y)[x]; }
+
+  int rows = 0;
+  int cols = 0;
+  unsigned char* data = nullptr;
+  size_t step = 0;
+
+ private:
+  int type_ = kType8UC1;
+  std::shared_ptr<unsigned char> storage;
+};
+
+} // namespace lite
+} // namespace vc
+
+#endif //WASMSAMPLE_IMAGE_LITE_MAT_H_
@@ -0,0 +1,70 @@
+#ifndef WASMSAMPLE_IMAGE_LITE_SIMD_H_
+#define WASMSAMPLE_IMAGE_LITE_SIMD_H_
+
+#include <cstdint>
+#include <cstring>
+
+// 128-bit vectors for the lite image kernels, written with GCC/Clang vector extensions so the same
+// code lowers to WASM SIMD (-msimd128) and to SSE/AVX natively. Kernels keep a scalar tail and a
+// scalar fallback when VC_LITE_SIMD is not defined.
+#if (defined(__wasm_simd128__) || defined(__SSE2__)) && (defined(__clang__) || __GNUC__ >= 9)
+#define VC_LITE_SIMD 1
+
+namespace vc {
+namespace lite {
+namespace simd {
+
+typedef float f32x4 __attribute__((vector_size(16)));
+typedef int32_t i32x4 __attribute__((vector_size(16)));
+typedef uint8_t u8x4 __attribute__((vector_size(4)));
+typedef uint8_t u8x16 __attribute__((vector_size(16)));
+typedef uint16_t u16x16 __attribute__((vector_size(32)));
+
+inline f32x4 Splat(float v) { return f32x4{v, v, v, v}; }
+
+inline f32x4 Load(const float* src) {
+  f32x4 v;
+  std::memcpy(&v, src, sizeof(v));
+  return v;
+}
+
+inline void Store(float* dst, f32x4 v) {
+  std::memcpy(dst, &v, sizeof(v));
+}
+
+inline f32x4 LoadU8(const uint8_t* src) {
+  u8x4 v;
+  std::memcpy(&v, src, sizeof(v));
+  return __builtin_convertvector(v, f32x4);
+}
+
+// Rounds half away from zero like cvRound for the non-negative values the kernels produce, then
+// saturates to [0, 255]
+inline void StoreU8(uint8_t* dst, f32x4 v) {
+  const auto lo = Splat(0.f), hi = Splat(255.f);
+  v += Splat(0.5f);
+  v = v < lo ? lo : v;
+  v = v > hi ? hi : v;
+  auto u = __builtin_convertvector(__builtin_convertvector(v, i32x4), u8x4);
+  std::memcpy(dst, &u, sizeof(u));
+}
+
+inline u8x16 LoadU8x16(const uint8_t* src) {
+  u8x16 v;
+  std::memcpy(&v, src, sizeof(v));
+  return v;
+}
+
+// Adds |a - b| per byte to 16-bit lanes, which hold up to 257 of them without overflow
+inline void AddAbsDiff(u16x16& acc, u8x16 a, u8x16 b) {
+  u8x16 diff = a > b ? a - b : b - a;
+  acc += __builtin_convertvector(diff, u16x16);
+}
+
+} // namespace simd
+} // namespace lite
+} // namespace vc
+
+#endif
+
+#endif //WASMSAMPLE_IMAGE_LITE_SIMD_H_
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench/kernel_registry.h"
+#include "opencv2/opencv.hpp"
+#include "platform/emscripten_compat.h"
+#include "sample_jpg.h"
+
+namespace {
+
+constexpr int kWarmupIterations = 5;
+constexpr int kIterations = 50;
+
+#ifdef TFLITE_WITH_WASM_SIMD
+constexpr bool kWithSimd = true;
+#else
+constexpr bool kWithSimd = false;
+#endif
+
+// Median of kIterations runs in nanoseconds
+double MedianNs(const vc::bench::KernelRun& kernel) {
+  using namespace std::chrono;
+  for (int i = 0; i < kWarmupIterations; ++i) kernel.run();
+
+  std::vector<double> times;
+  for (int i = 0; i < kIterations; ++i) {
+    auto start_time = high_resolution_clock::now();
+    kernel.run();
+    times.push_back(static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count()));
+  }
+  std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+  return times[times.size() / 2];
+}
+
+// Value of a "key: value" line of cv::getBuildInformation()
+std::string BuildInfo(const std::string& key) {
+  std::istringstream info(cv::getBuildInformation());
+  for (std::string line; std::getline(info, line);) {
+    auto pos = line.find(key + ":");
+    if (pos == std::string::npos) continue;
+    auto value = line.substr(pos + key.size() + 1);
+    value.erase(0, value.find_first_not_of(' '));
+    return value;
+  }
+  return "";
+}
+
+} // namespace
+
+// Prints a JSON report of every registered preprocessing kernel (bench/*_kernels.cpp) at camera
+// frame sizes, in ns per destination pixel. Kernels run single-threaded; OpenCV kernels are also
+// timed with PTHREAD_POOL_SIZE threads. Compare the output of the simd and nonsimd builds.
+EMSCRIPTEN_KEEPALIVE
+int main() {
+  std::vector<unsigned char> sample_image(elon_jpg, elon_jpg + elon_jpg_len);
+  auto image = cv::imdecode(sample_image, cv::IMREAD_COLOR);
+
+  const std::vector<cv::Size> sizes = {{640, 480}, {1280, 720}, {1920, 1080}};
+  auto entries = vc::bench::KernelRegistry::Instance().Entries();
+  // Registration order depends on the link order, keep the report stable
+  std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+    return a.primitive != b.primitive ? a.primitive < b.primitive : a.implementation < b.implementation;
+  });
+
+  printf("{\n");
+  printf("  \"simd\": %s, \"pthread_pool_size\": %d, \"iterations\": %d,\n",
+         kWithSimd ? "true" : "false", PTHREAD_POOL_SIZE, kIterations);
+  printf("  \"opencv\": {\"version\": \"%s\", \"baseline\": \"%s\", \"parallel_framework\": \"%s\"},\n",
+         CV_VERSION, BuildInfo("Baseline").c_str(), BuildInfo("Parallel framework").c_str());
+  printf("  \"kernels\": [\n");
+
+  bool first = true;
+  for (const auto& size : sizes) {
+    cv::Mat bgr, rgba;
+    cv::resize(image, bgr, size);
+    cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
+
+    for (const auto& entry : entries) {
+      auto kernel = entry.factory(rgba);
+      std::vector<int> thread_counts = {1};
+      if (entry.threaded && PTHREAD_POOL_SIZE > 1) thread_counts.push_back(PTHREAD_POOL_SIZE);
+
+      for (auto threads : thread_counts) {
+        cv::setNumThreads(threads);
+        auto ns = MedianNs(kernel);
+        printf("%s    {\"primitive\": \"%s\", \"implementation\": \"%s\", \"size\": \"%dx%d\", \"threads\": %d, "
+               "\"median_us\": %.3f, \"ns_per_pixel\": %.4f}",
+               first ? "" : ",\n", entry.primitive.c_str(), entry.implementation.c_str(),
+               size.width, size.height, threads, ns / 1e3, ns / static_cast<double>(kernel.pixels));
+        first = false;
+      }
+    }
+  }
+  cv::setNumThreads(-1);
+
+  printf("\n  ]\n");
+  printf("}\n");
+
+  return 0;
+}
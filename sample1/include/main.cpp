@@ -1,25 +1,175 @@
-#include <chrono>
-#include <emscripten.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include "cutemodel/cute_model.h"
 #include "blaze_face_wrapper.h"
+#include "concurrent/task_pool.h"
+#include "image/jpeg_decoder.h"
+#include "profile/clock.h"
+#include "platform/emscripten_compat.h"
 #include "sample_jpg.h"
 
+#ifdef TFLITE_WITH_WASM_SIMD
+constexpr bool kWithSimd = true;
+#else
+constexpr bool kWithSimd = false;
+#endif
+
+constexpr int kWarmupIterations = 10;
+constexpr int kIterations = 100;
+
+struct Summary {
+  double mean = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+};
+
+Summary Summarize(std::vector<double> samples) {
+  Summary summary;
+  if (samples.empty()) return summary;
+
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&](double p) {
+    auto index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[index];
+  };
+
+  for (auto sample : samples) summary.mean += sample;
+  summary.mean /= samples.size();
+  summary.p50 = percentile(0.50);
+  summary.p90 = percentile(0.90);
+  summary.p99 = percentile(0.99);
+  return summary;
+}
+
+void PrintSummary(const char* name, const Summary& summary, bool last) {
+  printf("        \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f}%s\n",
+         name, summary.mean, summary.p50, summary.p90, summary.p99, last ? "" : ",");
+}
+
+// Runs one configuration and prints it as a JSON object.
+// "opencv" converts BGR->RGB and goes through ResizeImage/AlignImage/NormalizeImage,
+// "fused" samples the BGR frame straight into the input tensor.
+void RunBenchmark(vc::BlazeFaceWrapper& face_wrapper, const cv::Mat& image_bgr,
+                  const std::string& path, int num_threads, bool last) {
+  std::vector<std::vector<double>> stage_samples(vc::kStageCount);
+  std::vector<double> total_samples;
+
+  cv::Mat image_rgb;
+  auto image_desc = vc::ImageDesc::Packed(vc::PixelFormat::kBGR, image_bgr.data, image_bgr.cols, image_bgr.rows,
+                                          static_cast<int>(image_bgr.step));
+
+  for (int i = 0; i < kWarmupIterations + kIterations; ++i) {
+    auto start_time = vc::NowMs();
+    vc::StageTimes times;
+
+    if (path == "opencv") {
+      auto convert_start = vc::NowMs();
+      cv::cvtColor(image_bgr, image_rgb, cv::COLOR_BGR2RGB);
+      auto convert_time = vc::NowMs() - convert_start;
+
+      face_wrapper.Execute(image_rgb, 0);
+      times = face_wrapper.LastStageTimes();
+      times[vc::Stage::kColorConvert] = convert_time;
+    } else {
+      face_wrapper.Execute(image_desc, 0);
+      times = face_wrapper.LastStageTimes();
+    }
+
+    auto total_time = vc::NowMs() - start_time;
+    if (i < kWarmupIterations) continue;
+
+    for (int s = 0; s < vc::kStageCount; ++s)
+      stage_samples[s].push_back(times.ms[s]);
+    total_samples.push_back(total_time);
+  }
+
+  printf("    {\n");
+  printf("      \"path\": \"%s\", \"width\": %d, \"height\": %d, \"threads\": %d,\n",
+         path.c_str(), image_bgr.cols, image_bgr.rows, num_threads);
+  printf("      \"stages_ms\": {\n");
+  for (int s = 0; s < vc::kStageCount; ++s)
+    PrintSummary(vc::StageName(static_cast<vc::Stage>(s)), Summarize(stage_samples[s]), false);
+  PrintSummary("total", Summarize(total_samples), true);
+  printf("      }\n");
+  printf("    }%s\n", last ? "" : ",");
+}
+
+// Full-size decode of the sample JPEG against the reduced decode for the model input
+void PrintDecode(const std::vector<unsigned char>& jpeg) {
+  vc::JpegDecoder decoder(vc::BlazeFaceShortRange::kInputWidth, vc::BlazeFaceShortRange::kInputHeight);
+  cv::Mat full;
+  std::vector<double> full_samples, reduced_samples;
+  for (int i = 0; i < kWarmupIterations + kIterations; ++i) {
+    auto start_time = vc::NowMs();
+    full = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+    auto full_time = vc::NowMs() - start_time;
+
+    start_time = vc::NowMs();
+    decoder.Decode(jpeg);
+    auto reduced_time = vc::NowMs() - start_time;
+
+    if (i < kWarmupIterations) continue;
+    full_samples.push_back(full_time);
+    reduced_samples.push_back(reduced_time);
+  }
+
+  const auto& reduced = decoder.Decode(jpeg);
+  auto print = [](const char* name, const cv::Mat& image, const Summary& summary, bool last) {
+    printf("    \"%s\": {\"width\": %d, \"height\": %d, \"bytes\": %zu, \"p50_ms\": %.4f, \"p90_ms\": %.4f}%s\n",
+           name, image.cols, image.rows, image.total() * image.elemSize(), summary.p50, summary.p90,
+           last ? "" : ",");
+  };
+  printf("  \"decode\": {\n");
+  print("full", full, Summarize(full_samples), false);
+  print("reduced", reduced, Summarize(reduced_samples), true);
+  printf("  },\n");
+}
+
+// Prints a JSON report of per-stage latency percentiles over input resolutions, thread counts and
+// preprocessing paths. Compare the output of the simd and nonsimd builds to track regressions.
 EMSCRIPTEN_KEEPALIVE
 int main() {
-  vc::BlazeFaceWrapper face_wrapper;
   std::vector<unsigned char> sample_image(elon_jpg, elon_jpg + elon_jpg_len);
   auto image = cv::imdecode(sample_image, cv::IMREAD_COLOR);
-  cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
-
-  using namespace std::chrono;
-  high_resolution_clock::duration time_duration(0);
-  for (auto i = 0 ; i < 100 ; i ++) {
-    auto start_time = high_resolution_clock::now();
-    auto [roi, angle] = face_wrapper.Execute(image, 0);
-    time_duration += duration_cast<nanoseconds>(high_resolution_clock::now() - start_time);
+
+  const std::vector<cv::Size> resolutions = {{640, 480}, {1280, 720}, {1920, 1080}};
+  std::vector<int> thread_counts;
+  // The fused path starts the task pool, whose workers keep their share of the pthread pool
+  for (int n = 1; n <= vc::TaskPool::MaxInterpreterThreads(); n *= 2) thread_counts.push_back(n);
+  const std::vector<std::string> paths = {"opencv", "fused"};
+
+  printf("{\n");
+  printf("  \"simd\": %s, \"pthread_pool_size\": %d, \"warmup\": %d, \"iterations\": %d,\n",
+         kWithSimd ? "true" : "false", PTHREAD_POOL_SIZE, kWarmupIterations, kIterations);
+  {
+    vc::BlazeFaceWrapper face_wrapper;
+    face_wrapper.Warmup();
+    const auto& cold_start = face_wrapper.ColdStart();
+    printf("  \"cold_start_ms\": {\"build\": %.4f, \"warmup\": %.4f},\n", cold_start.build_ms, cold_start.warmup_ms);
+    face_wrapper.Execute(image, 0);
+    printf("  \"memory\": %s,\n", face_wrapper.MemoryUsage().ToJson().c_str());
   }
-  printf("Avg time : %f\n", time_duration.count() / (100 * 1000000.0));
+  PrintDecode(sample_image);
+  printf("  \"thread_tuning\": %s,\n", vc::BlazeFaceWrapper::TuneThreads().ToJson().c_str());
+  printf("  \"runs\": [\n");
+
+  for (size_t t = 0; t < thread_counts.size(); ++t) {
+    vc::BlazeFaceWrapper face_wrapper(thread_counts[t]);
+    for (size_t r = 0; r < resolutions.size(); ++r) {
+      cv::Mat input;
+      cv::resize(image, input, resolutions[r]);
+      for (size_t p = 0; p < paths.size(); ++p) {
+        auto last = t + 1 == thread_counts.size() && r + 1 == resolutions.size() && p + 1 == paths.size();
+        RunBenchmark(face_wrapper, input, paths[p], thread_counts[t], last);
+      }
+    }
+  }
+
+  printf("  ]\n");
+  printf("}\n");
 
   return 0;
 }
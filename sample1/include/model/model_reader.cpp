@@ -4,8 +4,22 @@
 
 #include "model_reader.h"
 #include "model/blaze_face_model.h"
+#include "model/model_rewriter.h"
+#include "model/ssd_model.h"
+#include "vccc/log.hpp"
 namespace vc{
 ModelReader::ModelData ModelReader::ReadBlazeFaceModel() {
   return {(buffer_type) blaze_face_model_tflite, blaze_face_model_tflite_len};
 }
+
+ModelReader::ModelData ModelReader::ReadBlazeFaceModelRawInput() {
+  static const auto folded = [] {
+    auto model = FoldInputNormalization(blaze_face_model_tflite, blaze_face_model_tflite_len,
+                                        BlazeFaceShortRange::kInputScale, BlazeFaceShortRange::kInputOffset);
+    if (model.empty())
+      LOGD("Blaze Face : Input normalization could not be folded into the model");
+    return model;
+  }();
+  return {const_cast<buffer_type>(folded.data()), static_cast<unsigned int>(folded.size())};
+}
 }
\ No newline at end of file
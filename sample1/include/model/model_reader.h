@@ -17,6 +17,10 @@ class ModelReader {
   };
 
   static ModelData ReadBlazeFaceModel();
+
+  // The embedded model taking 0..255 pixels, with the input normalization folded into its first
+  // convolution (see FoldInputNormalization). Built on the first call; size 0 if it could not be.
+  static ModelData ReadBlazeFaceModelRawInput();
 };
 }
 #endif //WASMSAMPLE_MODEL_MODEL_READER_H_
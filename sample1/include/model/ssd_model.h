@@ -0,0 +1,158 @@
+#ifndef WASMSAMPLE_MODEL_SSD_MODEL_H_
+#define WASMSAMPLE_MODEL_SSD_MODEL_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace vc {
+
+// Compile-time geometry of an SSD-style model with MediaPipe anchors (one anchor center per
+// feature map cell, two anchors per layer sharing a stride). A new model is a new descriptor.
+struct BlazeFaceShortRange {
+  static constexpr int kInputWidth = 128;
+  static constexpr int kInputHeight = 128;
+  static constexpr std::array<int, 4> kStrides{8, 16, 16, 16};
+  static constexpr float kAnchorOffset = 0.5f;
+
+  // Input pixels are x * kInputScale + kInputOffset, in [-1, 1]
+  static constexpr float kInputScale = 1 / 127.5f;
+  static constexpr float kInputOffset = -1.f;
+
+  // Per anchor: box center x, y, width, height, then x, y of each keypoint, in input pixels
+  // relative to the anchor center
+  static constexpr int kNumKeypoints = 6;
+  static constexpr int kKeypointOffset = 4;
+  static constexpr int kBoxSize = kKeypointOffset + 2 * kNumKeypoints;
+
+  // Anchor centers are normalized, this scales them to input pixels
+  static constexpr float kAnchorScale = 128.f;
+};
+
+struct AnchorCenter {
+  float x = 0;
+  float y = 0;
+};
+
+namespace ssd_detail {
+
+// Calls visit(stride, anchors_per_cell) for each group of layers sharing a stride
+template<typename Model, typename Visit>
+constexpr void ForEachStrideGroup(Visit visit) {
+  const auto& strides = Model::kStrides;
+  size_t layer = 0;
+  while (layer < strides.size()) {
+    auto last = layer;
+    int anchors_per_cell = 0;
+    while (last < strides.size() && strides[last] == strides[layer]) {
+      anchors_per_cell += 2;
+      ++last;
+    }
+    visit(strides[layer], anchors_per_cell);
+    layer = last;
+  }
+}
+
+template<typename Model>
+constexpr int CountAnchors() {
+  int count = 0;
+  ForEachStrideGroup<Model>([&count](int stride, int anchors_per_cell) {
+    count += (Model::kInputHeight / stride) * (Model::kInputWidth / stride) * anchors_per_cell;
+  });
+  return count;
+}
+
+template<typename Model, int N>
+constexpr std::array<AnchorCenter, N> MakeAnchors() {
+  std::array<AnchorCenter, N> anchors{};
+  int index = 0;
+  ForEachStrideGroup<Model>([&anchors, &index](int stride, int anchors_per_cell) {
+    auto rows = Model::kInputHeight / stride, cols = Model::kInputWidth / stride;
+    for (int y = 0; y < rows; ++y) {
+      for (int x = 0; x < cols; ++x) {
+        for (int i = 0; i < anchors_per_cell; ++i) {
+          anchors[index].x = (x + Model::kAnchorOffset) / cols;
+          anchors[index].y = (y + Model::kAnchorOffset) / rows;
+          ++index;
+        }
+      }
+    }
+  });
+  return anchors;
+}
+
+} // namespace ssd_detail
+
+// Anchors and decoding of Model, with every loop bound known at compile time
+template<typename Model>
+class SsdDecoder {
+ public:
+  static constexpr int kNumAnchors = ssd_detail::CountAnchors<Model>();
+  static constexpr int kBoxSize = Model::kBoxSize;
+  static constexpr int kNumKeypoints = Model::kNumKeypoints;
+
+  static constexpr std::array<AnchorCenter, kNumAnchors> kAnchors = ssd_detail::MakeAnchors<Model, kNumAnchors>();
+
+  // Box and keypoints of one anchor in input pixels
+  struct Decoded {
+    std::array<float, 4> box{};  // xmin, ymin, xmax, ymax
+    std::array<AnchorCenter, kNumKeypoints> keypoints{};
+  };
+
+  // Index of the highest score, the first one on ties
+  static int ArgMax(const float* scores) {
+    int best = 0;
+    auto best_score = scores[0];
+    for (int i = 1; i < kNumAnchors; ++i) {
+      if (scores[i] > best_score) {
+        best_score = scores[i];
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  static Decoded Decode(const float* raw_boxes, int index) {
+    const auto* raw = raw_boxes + kBoxSize * index;
+    const auto& anchor = kAnchors[index];
+    const auto ax = anchor.x * Model::kAnchorScale, ay = anchor.y * Model::kAnchorScale;
+
+    Decoded decoded;
+    auto x_center = raw[0] + ax, y_center = raw[1] + ay;
+    auto half_width = raw[2] / 2.f, half_height = raw[3] / 2.f;
+    decoded.box = {x_center - half_width, y_center - half_height, x_center + half_width, y_center + half_height};
+    for (int i = 0; i < kNumKeypoints; ++i) {
+      decoded.keypoints[i].x = raw[Model::kKeypointOffset + 2 * i] + ax;
+      decoded.keypoints[i].y = raw[Model::kKeypointOffset + 2 * i + 1] + ay;
+    }
+    return decoded;
+  }
+
+  // Copies the outputs of one item of a batched invoke to dst (kNumAnchors * values_per_anchor
+  // values). batch_major outputs hold the anchors of each item in turn; models whose reshapes keep
+  // batch 1 instead hold each stride group of every item in turn.
+  static void Unbatch(const float* batched, int batch_size, int item, int values_per_anchor, bool batch_major,
+                      float* dst) {
+    if (batch_major) {
+      std::copy_n(batched + item * kNumAnchors * values_per_anchor, kNumAnchors * values_per_anchor, dst);
+      return;
+    }
+    ssd_detail::ForEachStrideGroup<Model>([&](int stride, int anchors_per_cell) {
+      auto count = (Model::kInputHeight / stride) * (Model::kInputWidth / stride) * anchors_per_cell
+                 * values_per_anchor;
+      dst = std::copy_n(batched + item * count, count, dst);
+      batched += batch_size * count;
+    });
+  }
+
+  // Whether a loaded model has this geometry
+  static bool Matches(int input_width, int input_height, size_t boxes_size, size_t scores_size) {
+    return input_width == Model::kInputWidth && input_height == Model::kInputHeight
+        && boxes_size == static_cast<size_t>(kNumAnchors) * kBoxSize
+        && scores_size == static_cast<size_t>(kNumAnchors);
+  }
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_MODEL_SSD_MODEL_H_
@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "blaze_face_wrapper.h"
+#include "concurrent/task_pool.h"
+#include "detector/pipelined_face_detector.h"
+#include "profile/clock.h"
+#include "platform/emscripten_compat.h"
+#include "sample_jpg.h"
+
+constexpr int kWarmupFrames = 10;
+constexpr int kFrames = 200;
+
+// Frames per second of sequential Execute() against PipelinedFaceDetector on the same input.
+// The pipelined rate should approach 1 / (slowest stage).
+EMSCRIPTEN_KEEPALIVE
+int main() {
+  // The sequential run starts the task pool, leave the pipeline's stage threads their share
+  vc::TaskPool::Configure(PTHREAD_POOL_SIZE - vc::PipelinedFaceDetector::kStageThreads);
+
+  std::vector<unsigned char> sample_image(elon_jpg, elon_jpg + elon_jpg_len);
+  auto image = cv::imdecode(sample_image, cv::IMREAD_COLOR);
+  cv::resize(image, image, {1280, 720});
+  auto image_desc = vc::ImageDesc::Packed(vc::PixelFormat::kBGR, image.data, image.cols, image.rows,
+                                          static_cast<int>(image.step));
+
+  // Sequential, including the same frame copy the pipeline does on Submit
+  double sequential_fps = 0;
+  {
+    vc::BlazeFaceWrapper face_wrapper(1);
+    std::vector<unsigned char> pixels;
+    vc::Angle angle = 0;
+    double start_time = 0;
+    for (int i = 0; i < kWarmupFrames + kFrames; ++i) {
+      if (i == kWarmupFrames) start_time = vc::NowMs();
+      auto frame = vc::CopyImage(image_desc, pixels);
+      angle = face_wrapper.Execute(frame, angle).second;
+    }
+    sequential_fps = kFrames * 1000 / (vc::NowMs() - start_time);
+  }
+
+  vc::PipelinedFaceDetector detector;
+  detector.Start();
+
+  vc::FaceResult result;
+  int found = 0;
+  double start_time = 0;
+  for (int i = 0, done = 0; done < kWarmupFrames + kFrames;) {
+    if (i < kWarmupFrames + kFrames && detector.Submit(image_desc, 0) != 0) {
+      ++i;
+      continue;
+    }
+    if (!detector.Poll(result, 1000)) {
+      printf("FAIL : no result within 1 s after %d of %d frames\n", done, kWarmupFrames + kFrames);
+      detector.Stop();
+      return 1;
+    }
+    if (++done == kWarmupFrames) {
+      start_time = vc::NowMs();
+      detector.SnapshotDetectorStats(true);
+    }
+    if (done > kWarmupFrames) found += result.found;
+  }
+  auto pipelined_fps = kFrames * 1000 / (vc::NowMs() - start_time);
+  detector.Stop();
+
+  auto stats = detector.SnapshotDetectorStats(false);
+  double slowest_ms = 0;
+  printf("Stage means (ms) :");
+  for (int s = 0; s < vc::kStageCount; ++s) {
+    const auto& histogram = stats.stages[s];
+    if (histogram.count == 0) continue;
+    printf(" %s=%.3f", vc::StageName(static_cast<vc::Stage>(s)), histogram.Mean());
+    slowest_ms = std::max(slowest_ms, histogram.Mean());
+  }
+  printf("\n");
+
+  printf("Sequential FPS : %f\n", sequential_fps);
+  printf("Pipelined FPS : %f, Found : %d/%d\n", pipelined_fps, found, kFrames);
+  printf("1 / slowest stage : %f\n", slowest_ms > 0 ? 1000 / slowest_ms : 0);
+
+  return 0;
+}
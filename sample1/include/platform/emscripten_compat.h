@@ -0,0 +1,13 @@
+#ifndef WASMSAMPLE_PLATFORM_EMSCRIPTEN_COMPAT_H_
+#define WASMSAMPLE_PLATFORM_EMSCRIPTEN_COMPAT_H_
+
+// Lets the entry points build natively as well as with emcc.
+// Everything else that depends on Emscripten checks __EMSCRIPTEN__ where it is used.
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE
+#endif
+
+#endif //WASMSAMPLE_PLATFORM_EMSCRIPTEN_COMPAT_H_
@@ -0,0 +1,24 @@
+#ifndef WASMSAMPLE_PROFILE_CLOCK_H_
+#define WASMSAMPLE_PROFILE_CLOCK_H_
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <chrono>
+#endif
+
+namespace vc {
+
+// Monotonic time in milliseconds. performance.now() on the web, which is shared by all pthreads.
+inline double NowMs() {
+#ifdef __EMSCRIPTEN__
+  return emscripten_get_now();
+#else
+  using namespace std::chrono;
+  return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_CLOCK_H_
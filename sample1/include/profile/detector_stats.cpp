@@ -0,0 +1,99 @@
+#include "profile/detector_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace vc {
+
+void LatencyHistogram::Add(double ms) {
+  int bucket = 0;
+  for (double bound = kFirstBucketMs; bucket < kBuckets - 1 && ms >= bound; bound *= 2)
+    ++bucket;
+
+  ++buckets[bucket];
+  ++count;
+  sum_ms += ms;
+  max_ms = std::max(max_ms, ms);
+}
+
+double LatencyHistogram::BucketUpperBound(int bucket) {
+  if (bucket >= kBuckets - 1)
+    return INFINITY;
+  return kFirstBucketMs * std::ldexp(1.0, bucket);
+}
+
+namespace {
+
+void WriteHistogram(std::ostream& out, const LatencyHistogram& histogram) {
+  out << "{\"count\":" << histogram.count
+      << ",\"mean_ms\":" << histogram.Mean()
+      << ",\"max_ms\":" << histogram.max_ms
+      << ",\"buckets\":[";
+  for (int i = 0; i < LatencyHistogram::kBuckets; ++i)
+    out << (i ? "," : "") << histogram.buckets[i];
+  out << "]}";
+}
+
+} // namespace
+
+std::string DetectorStats::ToJson() const {
+  std::stringstream out;
+
+  out << "{\"frames\":" << frames
+      << ",\"detected\":" << detected
+      << ",\"below_threshold\":" << below_threshold
+      << ",\"reused\":" << reused
+      << ",\"skip_ratio\":" << SkipRatio()
+      << ",\"last_score\":" << last_score;
+
+  out << ",\"bucket_upper_bounds_ms\":[";
+  for (int i = 0; i < LatencyHistogram::kBuckets - 1; ++i)
+    out << (i ? "," : "") << LatencyHistogram::BucketUpperBound(i);
+  out << "]";
+
+  out << ",\"last_frame_ms\":{";
+  for (int i = 0; i < kStageCount; ++i)
+    out << (i ? "," : "") << '"' << StageName(static_cast<Stage>(i)) << "\":" << last_frame.ms[i];
+  out << ",\"total\":" << last_frame.total() << "}";
+
+  out << ",\"stages\":{";
+  for (int i = 0; i < kStageCount; ++i) {
+    out << (i ? "," : "") << '"' << StageName(static_cast<Stage>(i)) << "\":";
+    WriteHistogram(out, stages[i]);
+  }
+  out << ",\"total\":";
+  WriteHistogram(out, total);
+  out << "}}";
+
+  return out.str();
+}
+
+void StatsCollector::Record(const StageTimes& times, bool detected, float score, bool reused) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  ++stats.frames;
+  // A reused frame repeats the last result, detected and below_threshold count frames the model ran on
+  if (reused) ++stats.reused;
+  else if (detected) ++stats.detected;
+  else ++stats.below_threshold;
+
+  stats.last_score = score;
+  stats.last_frame = times;
+
+  // Stages that did not run in this frame are left out of their histogram
+  for (int i = 0; i < kStageCount; ++i) {
+    if (times.ms[i] > 0)
+      stats.stages[i].Add(times.ms[i]);
+  }
+  stats.total.Add(times.total());
+}
+
+DetectorStats StatsCollector::Snapshot(bool reset) {
+  std::lock_guard<std::mutex> lock(mutex);
+  DetectorStats snapshot = stats;
+  if (reset) stats = DetectorStats();
+  return snapshot;
+}
+
+} // namespace vc
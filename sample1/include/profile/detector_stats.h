@@ -0,0 +1,60 @@
+#ifndef WASMSAMPLE_PROFILE_DETECTOR_STATS_H_
+#define WASMSAMPLE_PROFILE_DETECTOR_STATS_H_
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "profile/stage_timer.h"
+
+namespace vc {
+
+// Latency histogram with log2 buckets. Bucket i counts samples below kFirstBucketMs * 2^i,
+// the last bucket counts everything above.
+struct LatencyHistogram {
+  static constexpr int kBuckets = 16;
+  static constexpr double kFirstBucketMs = 0.0625;
+
+  std::array<uint32_t, kBuckets> buckets{};
+  uint32_t count = 0;
+  double sum_ms = 0;
+  double max_ms = 0;
+
+  void Add(double ms);
+  double Mean() const { return count > 0 ? sum_ms / count : 0; }
+  static double BucketUpperBound(int bucket);
+};
+
+struct DetectorStats {
+  uint64_t frames = 0;
+  uint64_t detected = 0;         // frames the model ran on, by outcome
+  uint64_t below_threshold = 0;
+  uint64_t reused = 0;  // answered by the change gate without inference, counted in frames too
+
+  float last_score = 0;
+  StageTimes last_frame;
+
+  std::array<LatencyHistogram, kStageCount> stages;
+  LatencyHistogram total;
+
+  double SkipRatio() const { return frames > 0 ? static_cast<double>(reused) / static_cast<double>(frames) : 0; }
+
+  std::string ToJson() const;
+};
+
+// Always-on counters of a detector. Record() is called once per frame by the detector thread,
+// Snapshot() may be called from any thread.
+class StatsCollector {
+ public:
+  void Record(const StageTimes& times, bool detected, float score, bool reused = false);
+  DetectorStats Snapshot(bool reset);
+
+ private:
+  std::mutex mutex;
+  DetectorStats stats;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_DETECTOR_STATS_H_
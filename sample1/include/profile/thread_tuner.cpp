@@ -0,0 +1,158 @@
+#include "profile/thread_tuner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "concurrent/task_pool.h"
+#include "cutemodel/cute_model.h"
+#include "profile/clock.h"
+#include "vccc/log.hpp"
+
+namespace vc {
+
+namespace {
+
+std::mutex cache_mutex;
+std::map<std::string, int> cache;
+
+int MaxThreads(const ThreadTuneOptions& options) {
+  int max_threads = static_cast<int>(std::thread::hardware_concurrency());
+  if (max_threads <= 0) max_threads = 1;
+  // Interpreter threads come from the pthread pool on Emscripten, next to the task pool's workers
+  max_threads = std::min(max_threads, TaskPool::MaxInterpreterThreads());
+  if (options.max_threads > 0)
+    max_threads = std::min(max_threads, options.max_threads);
+  return std::max(max_threads, 1);
+}
+
+double Percentile(std::vector<double> samples, double p) {
+  std::sort(samples.begin(), samples.end());
+  return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5)];
+}
+
+} // namespace
+
+std::string ThreadTuning::ToJson() const {
+  std::stringstream out;
+  out << "{\"num_threads\":" << num_threads
+      << ",\"from_cache\":" << (from_cache ? "true" : "false")
+      << ",\"signature\":\"" << signature << "\",\"median_ms\":[";
+  for (size_t i = 0; i < median_ms.size(); ++i)
+    out << (i ? "," : "") << median_ms[i];
+  out << "],\"p90_ms\":[";
+  for (size_t i = 0; i < p90_ms.size(); ++i)
+    out << (i ? "," : "") << p90_ms[i];
+  out << "]}";
+  return out.str();
+}
+
+std::string ThreadTuner::Signature(const void* model_buffer, size_t model_size) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  auto bytes = static_cast<const unsigned char*>(model_buffer);
+  for (size_t i = 0; i < model_size; ++i)
+    hash = (hash ^ bytes[i]) * 16777619u;
+
+  std::stringstream out;
+  out << "hc" << std::thread::hardware_concurrency();
+#ifdef PTHREAD_POOL_SIZE
+  out << "-pool" << PTHREAD_POOL_SIZE;
+#endif
+  out << "-interp" << TaskPool::MaxInterpreterThreads();
+#ifdef TFLITE_WITH_WASM_SIMD
+  out << "-simd";
+#endif
+  out << "-model" << std::hex << hash;
+  return out.str();
+}
+
+ThreadTuning ThreadTuner::Tune(const void* model_buffer, size_t model_size, const ThreadTuneOptions& options) {
+  auto max_threads = MaxThreads(options);
+
+  ThreadTuning tuning;
+  tuning.signature = Signature(model_buffer, model_size) + "-max" + std::to_string(max_threads);
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(tuning.signature);
+    if (it != cache.end()) {
+      tuning.num_threads = it->second;
+      tuning.from_cache = true;
+      return tuning;
+    }
+  }
+
+  std::vector<bool> stable;
+  for (int num_threads = 1; num_threads <= max_threads; ++num_threads) {
+    cute::CuteModel model;
+    cute::CuteModelBuilder builder({model_buffer, model_size, num_threads, false});
+    builder.build(model);
+
+    // Content does not matter for timing, but keep denormals and NaNs out
+    size_t input_size = 1;
+    for (auto dim : model.inputTensorDims(0)) input_size *= dim;
+    std::memset(model.inputData(0), 0, input_size * sizeof(float));
+
+    std::vector<double> samples;
+    for (int i = 0; i < options.warmup + options.iterations; ++i) {
+      auto start = NowMs();
+      model.invoke();
+      if (i >= options.warmup) samples.push_back(NowMs() - start);
+    }
+
+    auto median = Percentile(samples, 0.5);
+    auto p90 = Percentile(samples, 0.9);
+    tuning.median_ms.push_back(median);
+    tuning.p90_ms.push_back(p90);
+    stable.push_back(p90 <= median * options.max_spread);
+    LOGD("Thread tuning: threads=", num_threads, " median=", median, "ms p90=", p90, "ms");
+  }
+
+  // Fastest stable median, falling back to all settings if none was stable
+  bool any_stable = std::find(stable.begin(), stable.end(), true) != stable.end();
+  double best = -1;
+  for (size_t i = 0; i < tuning.median_ms.size(); ++i) {
+    if (any_stable && !stable[i]) continue;
+    if (best < 0 || tuning.median_ms[i] < best) best = tuning.median_ms[i];
+  }
+  for (size_t i = 0; i < tuning.median_ms.size(); ++i) {
+    if (any_stable && !stable[i]) continue;
+    if (tuning.median_ms[i] <= best * (1 + options.tolerance)) {
+      tuning.num_threads = static_cast<int>(i) + 1;
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache[tuning.signature] = tuning.num_threads;
+  return tuning;
+}
+
+std::string ThreadTuner::SaveCache() {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  std::stringstream out;
+  for (const auto& [signature, num_threads] : cache)
+    out << signature << '=' << num_threads << '\n';
+  return out.str();
+}
+
+void ThreadTuner::LoadCache(const std::string& text) {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  std::stringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    auto pos = line.rfind('=');
+    if (pos == std::string::npos) continue;
+    auto num_threads = std::atoi(line.c_str() + pos + 1);
+    if (num_threads > 0)
+      cache[line.substr(0, pos)] = num_threads;
+  }
+}
+
+} // namespace vc
@@ -0,0 +1,48 @@
+#ifndef WASMSAMPLE_PROFILE_THREAD_TUNER_H_
+#define WASMSAMPLE_PROFILE_THREAD_TUNER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace vc {
+
+struct ThreadTuneOptions {
+  int max_threads = 0;        // caller's budget, 0 for no cap besides the hardware and pool size
+  int warmup = 3;
+  int iterations = 10;
+  double tolerance = 0.05;    // fewer threads win if within this fraction of the fastest
+  double max_spread = 1.5;    // p90 / median above this counts as unstable
+};
+
+struct ThreadTuning {
+  int num_threads = 1;
+  bool from_cache = false;
+  std::string signature;
+  std::vector<double> median_ms;  // median invoke time of 1..N threads, empty if from cache
+  std::vector<double> p90_ms;
+
+  std::string ToJson() const;
+};
+
+// Picks the inference thread count by timing invokes of the model at 1..N threads.
+//
+// N is min(options.max_threads, hardware concurrency, TaskPool::MaxInterpreterThreads()). The
+// fastest stable setting wins, and the choice is cached under Signature() and N so later calls on
+// the same kind of device skip the calibration.
+class ThreadTuner {
+ public:
+  static ThreadTuning Tune(const void* model_buffer, size_t model_size, const ThreadTuneOptions& options = {});
+
+  // Hardware concurrency, pthread pool size and the interpreter threads it leaves, SIMD and a hash of
+  // the model
+  static std::string Signature(const void* model_buffer, size_t model_size);
+
+  // Cache as "signature=threads" lines, for persisting it across sessions (e.g. in localStorage)
+  static std::string SaveCache();
+  static void LoadCache(const std::string& cache);
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_THREAD_TUNER_H_
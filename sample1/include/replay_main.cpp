@@ -0,0 +1,174 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "blaze_face_wrapper.h"
+#include "capture/frame_stream.h"
+#include "detector/async_face_detector.h"
+#include "profile/clock.h"
+#include "platform/emscripten_compat.h"
+
+namespace {
+
+struct ReplayOptions {
+  bool realtime = false;
+  bool async = false;
+  bool frames = false;
+  float gate = 0;  // change gate threshold, 0 for off
+  double target_ms = 0;  // QoS latency target, 0 for off
+  int num_threads = 2;
+  std::string path;
+};
+
+void WaitUntil(double time_ms) {
+  auto remaining = time_ms - vc::NowMs();
+  if (remaining > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>(remaining * 1000)));
+}
+
+// Execute on every frame with the angle round trip of findFace
+int ReplaySequential(vc::FrameReplayer& replayer, const ReplayOptions& options) {
+  vc::BlazeFaceWrapper face_wrapper(options.num_threads);
+  face_wrapper.Warmup();
+  if (options.gate > 0) face_wrapper.EnableChangeGate(true, options.gate);
+  if (options.target_ms > 0) {
+    vc::QosOptions qos;
+    qos.target_ms = options.target_ms;
+    face_wrapper.SetQos(qos);
+  }
+
+  int found = 0, late = 0;
+  double lag_sum = 0;
+  vc::Angle angle = 0;
+  vc::ReplayFrame frame;
+
+  if (options.frames) printf("  \"frames\": [\n");
+  auto start_time = vc::NowMs();
+  while (replayer.Next(frame)) {
+    if (options.realtime) {
+      WaitUntil(start_time + frame.timestamp_ms);
+      // Still busy with the previous frame when this one arrived
+      auto lag = vc::NowMs() - (start_time + frame.timestamp_ms);
+      if (lag > 1) {
+        ++late;
+        lag_sum += lag;
+      }
+    }
+
+    auto face = face_wrapper.Detect(frame.image, angle);
+    const auto& roi = face.roi;
+    angle = face.angle;
+    found += !roi.empty();
+
+    if (options.frames) {
+      printf("    {\"index\": %d, \"timestamp_ms\": %.3f, \"found\": %s", frame.index, frame.timestamp_ms,
+             roi.empty() ? "false" : "true");
+      if (!roi.empty())
+        printf(", \"roi\": [%d, %d, %d, %d], \"angle\": %.4f", roi[0], roi[1], roi[2], roi[3], angle);
+      if (options.gate > 0 || options.target_ms > 0) printf(", \"reused\": %s", face.reused ? "true" : "false");
+      if (options.target_ms > 0) printf(", \"threads\": %d, \"interval\": %d", face_wrapper.QosStatus().point.num_threads,
+                                        face_wrapper.QosStatus().point.interval);
+      printf("}%s\n", frame.index + 1 < replayer.FrameCount() ? "," : "");
+    }
+  }
+  auto elapsed = vc::NowMs() - start_time;
+  if (options.frames) printf("  ],\n");
+
+  printf("  \"found\": %d, \"late\": %d, \"mean_lag_ms\": %.3f, \"elapsed_ms\": %.3f, \"fps\": %.3f,\n",
+         found, late, late > 0 ? lag_sum / late : 0.0, elapsed, replayer.FrameCount() * 1000 / elapsed);
+  printf("  \"qos\": %s,\n", face_wrapper.QosStatus().ToJson().c_str());
+  printf("  \"detector\": %s\n", face_wrapper.SnapshotStats(false).ToJson().c_str());
+  return 0;
+}
+
+// Submits frames to AsyncFaceDetector, frames it cannot keep up with are dropped
+int ReplayAsync(vc::FrameReplayer& replayer, const ReplayOptions& options) {
+  vc::AsyncFaceDetector detector;
+  detector.Start();
+
+  vc::FaceResult result;
+  int received = 0, found = 0;
+  vc::ReplayFrame frame;
+  auto start_time = vc::NowMs();
+  while (replayer.Next(frame)) {
+    if (options.realtime) WaitUntil(start_time + frame.timestamp_ms);
+    detector.Submit(frame.image);
+    if (detector.Poll(result)) {
+      ++received;
+      found += result.found;
+    }
+  }
+
+  auto submitted = static_cast<uint64_t>(replayer.FrameCount());
+  while (detector.GetStats().processed + detector.GetStats().dropped < submitted)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  auto elapsed = vc::NowMs() - start_time;
+  if (detector.Poll(result)) {
+    ++received;
+    found += result.found;
+  }
+  detector.Stop();
+
+  auto stats = detector.GetStats();
+  printf("  \"submitted\": %llu, \"processed\": %llu, \"dropped\": %llu, \"received\": %d, \"found\": %d,\n",
+         static_cast<unsigned long long>(stats.submitted), static_cast<unsigned long long>(stats.processed),
+         static_cast<unsigned long long>(stats.dropped), received, found);
+  printf("  \"elapsed_ms\": %.3f, \"processed_fps\": %.3f,\n", elapsed, stats.processed * 1000 / elapsed);
+  printf("  \"detector\": %s\n", detector.SnapshotDetectorStats(false).ToJson().c_str());
+  return stats.processed + stats.dropped == stats.submitted ? 0 : 1;
+}
+
+} // namespace
+
+// Streams a frame capture (.vcfs, see startFrameCapture in sample2) into the detector and prints a
+// JSON report:
+//   WasmReplayBenchmark [--realtime] [--async] [--frames] [--threads N] [--gate T] [--target MS] capture.vcfs
+// Frames run back to back unless --realtime paces them by their recorded timestamps. --async
+// submits them to AsyncFaceDetector, which drops what it cannot keep up with and ignores --threads.
+// --frames adds the per-frame results, for diffing tracking behavior between builds. --gate enables
+// the change gate with threshold T; the detector stats then show the skip ratio and the change_gate
+// stage next to invoke. --target holds the mean frame time under MS with the QoS controller, starting
+// from --threads threads as its maximum; the report then has the operating point it settled on.
+// In wasm, run it with node; the module is linked with NODERAWFS so the path is a host path.
+EMSCRIPTEN_KEEPALIVE
+int main(int argc, char** argv) {
+  ReplayOptions options;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--realtime") == 0) {
+      options.realtime = true;
+    } else if (std::strcmp(argv[i], "--async") == 0) {
+      options.async = true;
+    } else if (std::strcmp(argv[i], "--frames") == 0) {
+      options.frames = true;
+    } else if (std::strcmp(argv[i], "--gate") == 0 && i + 1 < argc) {
+      options.gate = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+      options.target_ms = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.num_threads = std::atoi(argv[++i]);
+    } else {
+      options.path = argv[i];
+    }
+  }
+
+  if (options.path.empty()) {
+    fprintf(stderr, "Usage: %s [--realtime] [--async] [--frames] [--threads N] [--gate T] [--target MS] capture.vcfs\n", argv[0]);
+    return 1;
+  }
+
+  vc::FrameReplayer replayer;
+  if (!replayer.Open(options.path)) {
+    fprintf(stderr, "Cannot read frame stream %s\n", options.path.c_str());
+    return 1;
+  }
+
+  printf("{\n");
+  printf("  \"path\": \"%s\", \"frames_in_stream\": %d, \"duration_ms\": %.3f, \"mode\": \"%s\", \"pacing\": \"%s\",\n",
+         options.path.c_str(), replayer.FrameCount(), replayer.DurationMs(), options.async ? "async" : "sequential",
+         options.realtime ? "recorded" : "max");
+  auto status = options.async ? ReplayAsync(replayer, options) : ReplaySequential(replayer, options);
+  printf("}\n");
+  return status;
+}
@@ -10,6 +10,16 @@ const face = document.querySelector(".content .overlay");
 const camWidth = 1280;
 const camHeight = 720;
 const canvasWidthPercent = 90;
+// Run detection on a wasm worker thread instead of the main thread.
+// Requires WasmSample built with async_face_detector (see Readme).
+const useAsyncDetector = false;
+// Pass camera frames in their native pixel format (WebCodecs) instead of reading them back from a canvas.
+// Requires WasmSample built with findFaceWithFormat (see Readme).
+const useVideoFrame = false;
+// Pick the inference thread count for this device before the first frame, capped at maxThreads (0: no cap).
+// Requires WasmSample built with calibrateThreads (see Readme).
+const calibrateThreads = false;
+const maxThreads = 0;
 block.style.width = canvasWidthPercent + "%";
 
 export function startCamera() {
@@ -19,12 +29,27 @@ export function startCamera() {
         const track = stream.getVideoTracks()[0];
         cameraThread = new CameraThread();
         if (cameraThread.init(track)) {
-            wasmWrapper.setFaceCallback(drawFace);
             video.srcObject = stream;
+            if (calibrateThreads) {
+                console.log(wasmWrapper.calibrateThreads(maxThreads));
+            }
             cameraThread.start();
-            cameraThread.setCallback((bitmap) => {
-                wasmWrapper.processFaceDetection(bitmap);
-            })
+            if (useAsyncDetector) {
+                wasmWrapper.startDetector();
+                cameraThread.setCallback((bitmap) => {
+                    wasmWrapper.submitFrame(bitmap);
+                });
+                requestAnimationFrame(pollFace);
+            } else {
+                wasmWrapper.setFaceCallback(drawFace);
+                cameraThread.setCallback((bitmap) => {
+                    if (useVideoFrame) {
+                        wasmWrapper.processVideoFrame(bitmap);
+                    } else {
+                        wasmWrapper.processFaceDetection(bitmap);
+                    }
+                });
+            }
         } else {
             cameraThread = null;
         }
@@ -33,6 +58,19 @@ export function startCamera() {
 
 export function stopCamera() {
     cameraThread.release();
+    if (useAsyncDetector) {
+        wasmWrapper.stopDetector();
+    }
+}
+
+/** @private */
+function pollFace() {
+    if (!cameraThread || !cameraThread.running) return;
+    const result = wasmWrapper.pollResult();
+    if (result) {
+        drawFace(result.left, result.top, result.right, result.bottom, result.angle);
+    }
+    requestAnimationFrame(pollFace);
 }
 
 /** @private */
@@ -1,5 +1,13 @@
 import { simd, threads } from "https://unpkg.com/wasm-feature-detect?module";
 
+// vc::PixelFormat
+const pixelFormats = {
+    'RGBA': 0, 'RGBX': 0,
+    'BGRA': 1, 'BGRX': 1,
+    'NV12': 4,
+    'I420': 6,
+};
+
 export class WasmWrapper {
     constructor() {
         this.loaded = false;
@@ -11,14 +19,52 @@ export class WasmWrapper {
             }
             let dir = useSimd? "simd" : "nonsimd";
             this.loadModuleScript_("./wasm/" + dir + "/WasmSample.js").then(() => {
+                const instantiateStart = performance.now();
                 createModule().then(instance => {
+                    // Compare builds with e.g. -DWITH_OPENCV=OFF
+                    console.log("Module instantiated in " + (performance.now() - instantiateStart) + "ms");
                     this.wasmModule = instance;
                     this.loaded = true;
+                    // The warm-up (one invoke plus XNNPACK weight packing) blocks the UI thread, so it
+                    // waits for idle time, usually while the camera permission prompt is open. If a frame
+                    // comes first, that frame pays the setup and the warm-up does nothing.
+                    const warmup = () => {
+                        const warmupMs = this.wasmModule.ccall('warmupDetector', 'number', [], []);
+                        console.log("Detector warm-up: " + warmupMs + "ms");
+                    };
+                    if (window.requestIdleCallback) {
+                        requestIdleCallback(warmup, {timeout: 2000});
+                    } else {
+                        setTimeout(warmup, 0);
+                    }
                 });
             });
         })
     }
 
+    // Re-acquires rotated or upside-down faces once tracking is lost, at the cost of one batched invoke per lost frame
+    setRotationRecovery(enable) {
+        this.wasmModule.ccall('setRotationRecovery', null, ['boolean'], [enable]);
+    }
+
+    // Skips inference while the scene around the face does not change; threshold 0 keeps the default
+    setChangeGate(enable, threshold = 0) {
+        this.wasmModule.ccall('setChangeGate', null, ['boolean', 'number'], [enable, threshold]);
+    }
+
+    // Adapts threads, rotation recovery and detection cadence to stay under targetMs per frame
+    setLatencyTarget(targetMs, maxThreads = 0) {
+        this.wasmModule.ccall('setLatencyTarget', null, ['number', 'number'], [targetMs, maxThreads]);
+    }
+
+    getQosStatus() {
+        return JSON.parse(this.wasmModule.ccall('getQosStatus', 'string', [], []));
+    }
+
+    wasLastFaceReused() {
+        return this.wasmModule.ccall('wasLastFaceReused', 'boolean', [], []);
+    }
+
     setFaceCallback(callback) {
         let faceCallback = this.wasmModule.addFunction(callback, 'viiiii');
         this.wasmModule.ccall('setFaceCallback', 'boolean', ['number'], [faceCallback]);
@@ -36,6 +82,166 @@ export class WasmWrapper {
         this.freeBuffer_(buffer);
     }
 
+    // Hands the frame's native layout (e.g. NV12/I420 from the camera) to wasm without a canvas round-trip.
+    // Falls back to processFaceDetection when WebCodecs is unavailable or the format is not supported.
+    async processVideoFrame(bitmap) {
+        if (typeof VideoFrame === 'undefined') {
+            this.processFaceDetection(bitmap);
+            return;
+        }
+        const frame = new VideoFrame(bitmap, {timestamp: 0});
+        const format = pixelFormats[frame.format];
+        if (format === undefined) {
+            frame.close();
+            this.processFaceDetection(bitmap);
+            return;
+        }
+
+        const size = frame.allocationSize();
+        const buffer = this.wasmModule._malloc(size);
+        const layout = await frame.copyTo(this.wasmModule.HEAPU8.subarray(buffer, buffer + size));
+        const planes = [0, 0, 0];
+        const strides = [0, 0, 0];
+        layout.forEach((plane, i) => {
+            planes[i] = buffer + plane.offset;
+            strides[i] = plane.stride;
+        });
+        this.angle = this.wasmModule.ccall(
+            'findFaceWithFormat',
+            'number',
+            ['number', 'number', 'number', 'number', 'number', 'number', 'number', 'number', 'number', 'number'],
+            [format, ...planes, ...strides, frame.visibleRect.width, frame.visibleRect.height, this.angle]);
+        this.wasmModule._free(buffer);
+        frame.close();
+    }
+
+    startDetector() {
+        this.wasmModule.ccall('startFaceDetector', 'boolean', [], []);
+        this.resultBuffer = this.wasmModule._malloc(6 * 4);
+    }
+
+    stopDetector() {
+        this.wasmModule.ccall('stopFaceDetector', null, [], []);
+        this.freeBuffer_(this.resultBuffer);
+        this.resultBuffer = null;
+    }
+
+    submitFrame(bitmap) {
+        const blob = this.convertBitmapToBlob_(bitmap);
+        const buffer = this.createBuffer_(bitmap);
+        this.wasmModule.HEAPU8.set(blob.data, buffer);
+        this.wasmModule.ccall(
+            'submitFrame',
+            'number',
+            ['number', 'number', 'number'],
+            [buffer, bitmap.width, bitmap.height]);
+        this.freeBuffer_(buffer);
+    }
+
+    pollResult() {
+        if (!this.wasmModule.ccall('pollFaceResult', 'boolean', ['number'], [this.resultBuffer])) {
+            return null;
+        }
+        const [left, top, right, bottom, angle, frameId] =
+            this.wasmModule.HEAP32.subarray(this.resultBuffer >> 2, (this.resultBuffer >> 2) + 6);
+        return {left, top, right, bottom, angle, frameId};
+    }
+
+    // Loads a second-stage landmark model (e.g. face mesh) run on the detected face, see
+    // vc::CascadeDetector. scoreOutput is the index of the model's confidence output, -1 if none.
+    async loadCascadeModel(url, {landmarkStride = 3, scoreOutput = -1, trackScore = 0.9, maxPoints = 512} = {}) {
+        const model = new Uint8Array(await (await fetch(url)).arrayBuffer());
+        const buffer = this.wasmModule._malloc(model.length);
+        this.wasmModule.HEAPU8.set(model, buffer);
+        this.wasmModule.ccall(
+            'initCascade', 'boolean', ['number', 'number', 'number', 'number', 'number'],
+            [buffer, model.length, landmarkStride, scoreOutput, trackScore]);
+        this.wasmModule._free(buffer);
+        this.maxCascadePoints = maxPoints;
+        this.cascadeBuffer = this.wasmModule._malloc(maxPoints * 2 * 4);
+    }
+
+    // Landmarks of the face in frame pixels, [] without a face
+    findFaceLandmarks(bitmap) {
+        const blob = this.convertBitmapToBlob_(bitmap);
+        const buffer = this.createBuffer_(bitmap);
+        this.wasmModule.HEAPU8.set(blob.data, buffer);
+        const count = Math.min(this.maxCascadePoints, this.wasmModule.ccall(
+            'findFaceCascade',
+            'number',
+            ['number', 'number', 'number', 'number', 'number'],
+            [buffer, bitmap.width, bitmap.height, this.cascadeBuffer, this.maxCascadePoints]));
+        this.freeBuffer_(buffer);
+        const coords = this.wasmModule.HEAPF32.subarray(this.cascadeBuffer >> 2, (this.cascadeBuffer >> 2) + count * 2);
+        const points = [];
+        for (let i = 0; i < count; ++i) points.push({x: coords[2 * i], y: coords[2 * i + 1]});
+        return points;
+    }
+
+    droppedFrameCount() {
+        return this.wasmModule.ccall('getDroppedFrameCount', 'number', [], []);
+    }
+
+    // Picks the inference thread count for this device, at most maxThreads (0 for no cap).
+    // The choice is kept in localStorage, so only the first load pays for the calibration.
+    calibrateThreads(maxThreads = 0) {
+        const cacheKey = 'wasm-sample-thread-tuning';
+        const cache = window.localStorage.getItem(cacheKey);
+        if (cache) {
+            this.wasmModule.ccall('setThreadTuningCache', null, ['string'], [cache]);
+        }
+        const json = this.wasmModule.ccall('calibrateThreads', 'string', ['number'], [maxThreads]);
+        window.localStorage.setItem(
+            cacheKey, this.wasmModule.ccall('getThreadTuningCache', 'string', [], []));
+        return JSON.parse(json);
+    }
+
+    // Frame counts, last-frame timings and per-stage latency histograms, see vc::DetectorStats
+    detectorStats(async = false, reset = true) {
+        const json = this.wasmModule.ccall(
+            'getDetectorStats', 'string', ['boolean', 'boolean'], [async, reset]);
+        return JSON.parse(json);
+    }
+
+    enableTracing(capacity = 16384) {
+        this.wasmModule.ccall('enableTracing', null, ['number'], [capacity]);
+    }
+
+    disableTracing() {
+        this.wasmModule.ccall('disableTracing', null, [], []);
+    }
+
+    // Chrome trace-event JSON string, open it in chrome://tracing or https://ui.perfetto.dev
+    traceJson(clear = true) {
+        return this.wasmModule.ccall('getTraceJson', 'string', ['boolean'], [clear]);
+    }
+
+    // Records the frames given to findFace until stopCapture(), which returns them as a .vcfs Blob.
+    // Frames are kept in the Emscripten file system (JS memory), about 1.2MB per 640x480 RGBA frame.
+    startCapture() {
+        return this.wasmModule.ccall('startFrameCapture', 'boolean', ['string'], ['/capture.vcfs']);
+    }
+
+    stopCapture() {
+        const frames = this.wasmModule.ccall('stopFrameCapture', 'number', [], []);
+        const data = this.wasmModule.FS.readFile('/capture.vcfs');
+        this.wasmModule.FS.unlink('/capture.vcfs');
+        console.log("Captured " + frames + " frames");
+        return new Blob([data], {type: 'application/octet-stream'});
+    }
+
+    // Bytes held by the model, tensor arenas, image scratch, frame and trace buffers, and the heap,
+    // see vc::MemoryReport
+    memoryReport() {
+        return JSON.parse(this.wasmModule.ccall('getMemoryReport', 'string', [], []));
+    }
+
+    // Detectors and trace buffers created after this call size their buffers to stay under
+    // bytes of heap (0 turns the budget off)
+    setMemoryBudget(bytes) {
+        this.wasmModule.ccall('setMemoryBudget', null, ['number'], [bytes]);
+    }
+
     /** @private */
     async checkFeatures_() {
         let useSimd = await simd();
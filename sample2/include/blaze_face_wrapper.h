@@ -1,18 +1,29 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "cutemodel/cute_model.h"
-#include "opencv2/opencv.hpp"
+#include "image/change_detector.h"
+#include "image/cv_compat.h"
+#include "image/fused_sampler.h"
+#include "image/image_desc.h"
+#include "model/model_reader.h"
+#include "model/ssd_model.h"
+#include "profile/detector_stats.h"
+#include "profile/memory_report.h"
+#include "profile/qos_controller.h"
+#include "profile/stage_timer.h"
+#include "profile/thread_tuner.h"
 
 namespace vc {
 using Score = float;
 using Angle = double;
-using Point = cv::Point2f;
-using Point3 = cv::Point3f;
+using Point = cvx::Point2f;
+using Point3 = cvx::Point3f;
 using Ints = std::vector<int>;
 using Floats = std::vector<float>;
 using Doubles = std::vector<double>;
@@ -26,56 +37,179 @@ using ROI = iROI;
 
 using Landmarks = Points;
 using Landmarks3D = Point3s;
-using Image = cv::Mat;
+using Image = cvx::Mat;
 
 using FBox = std::pair<fROI, Points>;
 using Box = std::pair<ROI, Points>;
 using Result = std::pair<ROI, Angle>;
 using Detection = std::tuple<ROI, Score, Points>;
 
+// Placement of the resized input image inside the model input
+struct Letterbox {
+  int width = 0;
+  int height = 0;
+  int pad_left = 0;
+  int pad_top = 0;
+  double resize_ratio = 0.0;
+  std::array<double, 2> rotation_anchor{};
+};
+
+// One-time costs of a detector. build_ms covers parsing the model, building the interpreter and
+// allocating tensors (where XNNPACK packs the weights), warmup_ms the first invoke.
+struct ColdStartTimes {
+  double build_ms = 0;
+  double warmup_ms = 0;
+};
+
+// Everything the detector knows about the face in a frame, in frame pixels
+struct FaceDetection {
+  ROI roi;  // empty if no face was found
+  Score score = 0;
+  Landmarks landmarks;
+  Angle angle = 0;
+  bool reused = false;  // the result of an earlier frame, returned again by the change gate or QoS
+};
+
 class BlazeFaceWrapper {
+  friend class CascadeDetector;
+  friend class PipelinedFaceDetector;
+  friend class TiledFaceDetector;
+
  public:
   BlazeFaceWrapper();
+  explicit BlazeFaceWrapper(int num_threads);
+  // Another model with the same geometry, e.g. a quantized one. model_buffer must outlive the wrapper.
+  // With raw_input the model takes 0..255 pixels and the input is not normalized, e.g. for
+  // ModelReader::ReadBlazeFaceModelRawInput.
+  BlazeFaceWrapper(const void* model_buffer, size_t model_size, int num_threads, bool raw_input = false);
+
   Result Execute(const Image &input, Angle prior_rotation);
+  Result Execute(const ImageDesc& input, Angle prior_rotation);
+
+  // Like Execute, with the score and landmarks
+  FaceDetection Detect(const Image& input, Angle prior_rotation);
+  FaceDetection Detect(const ImageDesc& input, Angle prior_rotation);
+
+  // While no face is tracked, searches the upright input and its 90, -90 and 180 degree rotations in
+  // one batched invoke, then tracks from the best-scoring angle. Builds a second interpreter for the
+  // batch on first use. Off by default.
+  void EnableRecovery(bool enable);
+
+  // Returns the last inferred result again, marked as reused, while the frame around its face (the
+  // whole frame if there was none) differs from the inferred frame by less than threshold, see
+  // ChangeDetector. The check costs a few microseconds. ImageDesc overloads only, off by default.
+  void EnableChangeGate(bool enable, float threshold = ChangeDetector::kDefaultThreshold);
+
+  // Keeps the mean time per frame under options.target_ms by stepping the thread count, rotation
+  // recovery and the detection interval, see QosController. Threads stay under
+  // TaskPool::MaxInterpreterThreads(). Call after EnableRecovery; a target of 0 turns it off and
+  // keeps the current thread count.
+  void SetQos(const QosOptions& options);
+
+  // Current operating point. Call from the thread that runs Detect.
+  QosReport QosStatus() const;
+
+  // Records a span per TFLite operator of the model to the TraceRecorder. Installs an interpreter
+  // profiler, so invokes pay nothing while it is off. Call from the thread that runs Detect.
+  void EnableOpTracing(bool enable);
+
+  // Runs the first invoke on a blank input so its one-time setup is not paid by the first frame.
+  // Does nothing after the first call or the first inference.
+  void Warmup();
+
+  const ColdStartTimes& ColdStart() const;
+
+  // Rebuilds the interpreter with num_threads inference threads
+  void SetNumThreads(int num_threads);
+
+  // Calibrates the thread count for the embedded model, see ThreadTuner
+  static ThreadTuning TuneThreads(const ThreadTuneOptions& options = {});
+
+  // Per-stage timing of the last Execute
+  const StageTimes& LastStageTimes() const;
+
+  // Counters and latency histograms since the last reset. Safe to call from any thread.
+  DetectorStats SnapshotStats(bool reset);
+
+  // Model, tensor arenas, the largest image temporaries of the Image path so far, and the heap
+  MemoryReport MemoryUsage() const;
 
  protected:
+  // Geometry of the embedded model, checked against the loaded tensors by BuildModel
+  using Decoder = SsdDecoder<BlazeFaceShortRange>;
+
   void BuildModel(const cute::CuteModelBuilder& builder);
-  void InitAnchors();
   void InitOptions();
 
   Image PreProcess(const Image& image, Angle prior_rotation);
+  void PreProcess(const ImageDesc& image, Angle prior_rotation);
   Detection PostProcess(Angle rotation);
+  Detection PostProcess(const float* raw_boxes, const float* scores, size_t num_anchors,
+                        const Letterbox& box, Angle rotation) const;
+  void SampleInput(const ImageDesc& image, const Letterbox& box, Angle rotation, float* dst) const;
 
   Detection Run(const Image& image, Angle angle = 0);
-  static cv::Mat NormalizeImage(const Image& image);
+  Detection Run(const ImageDesc& image, Angle angle = 0);
+  Detection Recover(const Image& image);
+  Detection Recover(const ImageDesc& image);
+  Detection PostProcessRecovery() const;
+  static FaceDetection MakeFaceDetection(Detection detection);
+  bool SkipByInterval();
+  FaceDetection ReuseLastFace(double gate_ms);
+  void FinishInference(const FaceDetection& face);
+  void UpdateQos();
+  void ApplyQosPoint();
+  Letterbox ComputeLetterbox(int image_width, int image_height) const;
+  static AffineMap ModelToImageMap(const Letterbox& letterbox, int image_width, int image_height, Angle angle);
+  static Image NormalizeImage(const Image& image, float scale, float offset);
   Image ResizeImage(const Image& image);
   static Angle CalculateFaceAngleFromLandmarks(const Points& face_landmarks);
   static Image AlignImage(const Image& image, Angle angle, const std::vector<int>& dst_size, const ROI& roi={});
 
-  FBox DecodeBox(const Floats& raw_box, const cv::Point2f& anchor) const;
-  Box RealignOutputs(Floats roi, const Points& points, Angle rotation);
+  Box RealignOutputs(Floats roi, const Points& points, const Letterbox& letterbox, Angle rotation) const;
 
 
  private:
+  BlazeFaceWrapper(const ModelReader::ModelData& model_data, int num_threads);
+
   int r_index = 0;
   int c_index = 0;
-  double min_scale = 0.1484375;
 
+  const void* model_buffer = nullptr;
+  size_t model_size = 0;
+  int num_threads = 0;
   cute::CuteModel model;
-  std::vector<int> target_size;
-  std::vector<cv::Point2f> anchors;
-  std::array<double, 2> rotation_anchor{};
-
-  int num_strides = 0;
-  int num_keypoints = 6;
-  int keypoint_coord_offset = 4;
+  // Input pixels are x * input_scale + input_offset, 1 and 0 for a raw input model
+  float input_scale = BlazeFaceShortRange::kInputScale;
+  float input_offset = BlazeFaceShortRange::kInputOffset;
+
+  // Batch of rotated inputs searched while no face is tracked
+  cute::CuteModel recovery_model;
+  bool recovery_enabled = false;
+  bool tracking = false;
+
+  // Result of the last inference, for frames that skip it
+  FaceDetection last_face;
+  bool has_last_face = false;
+  int frames_since_inference = 0;
+
+  // Skips inference while the frame does not change
+  ChangeDetector change_detector;
+  bool change_gate_enabled = false;
+
+  std::unique_ptr<QosController> qos;
+  bool recovery_suspended = false;
+  std::vector<int> target_size{BlazeFaceShortRange::kInputHeight, BlazeFaceShortRange::kInputWidth};
+
+  Letterbox letterbox;
+  ColdStartTimes cold_start;
+  bool warmed_up = false;
+  StageTimes stage_times;
+  StatsCollector stats;
+  std::vector<double> op_trace_starts;
+  size_t image_scratch_bytes = 0;
 
-  int pad_left = 0;
-  int pad_top = 0;
-
-  double scale = 128.0;
   double threshold = 0.40;
-  double resize_ratio = 0.0;
 };
 
 } // namespace vc
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef WASMSAMPLE_CONCURRENT_LATEST_MAILBOX_H_
+#define WASMSAMPLE_CONCURRENT_LATEST_MAILBOX_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace vc {
+
+// Lock-free single-producer / single-consumer triple buffer.
+//
+// The producer always owns one slot (back), the consumer always owns one slot (front) and the
+// third slot (middle) is exchanged atomically between them. Publishing never blocks and never
+// waits for the consumer: if the consumer did not pick up the previous value it is overwritten,
+// i.e. the newest value wins.
+template<typename T>
+class LatestMailbox {
+ public:
+  LatestMailbox() = default;
+
+  LatestMailbox(const LatestMailbox&) = delete;
+  LatestMailbox& operator = (const LatestMailbox&) = delete;
+
+  // Producer side. Slot to be filled before calling Publish().
+  T& WriteSlot() { return slots[back]; }
+
+  // Producer side. Returns true if an unread value was dropped by this publish.
+  bool Publish() {
+    auto prev = middle.exchange(static_cast<uint8_t>(back | kFresh), std::memory_order_acq_rel);
+    back = prev & kIndexMask;
+    return (prev & kFresh) != 0;
+  }
+
+  // Consumer side. Returns true if a value newer than the last acquired one is now in ReadSlot().
+  bool Acquire() {
+    if ((middle.load(std::memory_order_relaxed) & kFresh) == 0)
+      return false;
+    auto prev = middle.exchange(front, std::memory_order_acq_rel);
+    front = prev & kIndexMask;
+    return true;
+  }
+
+  // Consumer side. Last acquired value.
+  T& ReadSlot() { return slots[front]; }
+  const T& ReadSlot() const { return slots[front]; }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFresh = 0x4;
+
+  std::array<T, 3> slots{};
+  std::atomic<uint8_t> middle{1};
+  uint8_t back = 0;   // owned by the producer
+  uint8_t front = 2;  // owned by the consumer
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_CONCURRENT_LATEST_MAILBOX_H_
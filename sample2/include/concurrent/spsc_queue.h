@@ -0,0 +1,65 @@
+#ifndef WASMSAMPLE_CONCURRENT_SPSC_QUEUE_H_
+#define WASMSAMPLE_CONCURRENT_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace vc {
+
+// Bounded lock-free single-producer / single-consumer ring buffer.
+//
+// Unlike LatestMailbox nothing is ever overwritten: TryPush() fails when the queue is full and
+// TryPop() fails when it is empty. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  SpscQueue() = default;
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator = (const SpscQueue&) = delete;
+
+  // Producer side
+  bool TryPush(T value) {
+    auto tail_ = tail.load(std::memory_order_relaxed);
+    if (tail_ - head.load(std::memory_order_acquire) == Capacity)
+      return false;
+    slots[tail_ & kMask] = std::move(value);
+    tail.store(tail_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool TryPop(T& value) {
+    auto head_ = head.load(std::memory_order_relaxed);
+    if (tail.load(std::memory_order_acquire) == head_)
+      return false;
+    value = std::move(slots[head_ & kMask]);
+    head.store(head_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t Size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  // Only while neither side is in use
+  void Clear() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t kMask = Capacity - 1;
+
+  std::array<T, Capacity> slots{};
+  std::atomic<size_t> head{0};  // written by the consumer
+  std::atomic<size_t> tail{0};  // written by the producer
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_CONCURRENT_SPSC_QUEUE_H_
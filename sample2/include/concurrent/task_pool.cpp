@@ -0,0 +1,152 @@
+#include "concurrent/task_pool.h"
+
+#include <algorithm>
+
+#include "profile/trace_recorder.h"
+
+namespace vc {
+
+namespace {
+
+std::atomic<int> configured_workers{-1};
+
+int ConfiguredWorkers() {
+  auto workers = configured_workers.load();
+  return workers >= 0 ? workers : std::max(1, PTHREAD_POOL_SIZE / 2);
+}
+
+// Worker identity of the current thread, for pushing to its own deque
+thread_local const TaskPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+} // namespace
+
+TaskPool& TaskPool::Instance() {
+  static TaskPool pool(ConfiguredWorkers());
+  return pool;
+}
+
+int TaskPool::MaxInterpreterThreads() {
+  return std::max(1, PTHREAD_POOL_SIZE - ConfiguredWorkers());
+}
+
+void TaskPool::Configure(int num_workers) {
+  configured_workers = std::max(num_workers, 0);
+}
+
+TaskPool::TaskPool(int num_workers) {
+  for (int i = 0; i < num_workers; ++i)
+    queues.emplace_back(std::make_unique<Queue>());
+  for (int i = 0; i < num_workers; ++i)
+    workers.emplace_back(&TaskPool::Loop, this, i);
+}
+
+TaskPool::~TaskPool() {
+  running = false;
+  for (size_t i = 0; i < workers.size(); ++i)
+    task_signal.Notify();
+  for (auto& worker : workers)
+    worker.join();
+}
+
+void TaskPool::Submit(std::function<void()> task) {
+  if (workers.empty()) {
+    task();
+    return;
+  }
+
+  auto target = current_pool == this ? static_cast<size_t>(current_worker)
+                                      : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+  {
+    std::lock_guard<std::mutex> lock(queues[target]->mutex);
+    queues[target]->tasks.push_back(std::move(task));
+  }
+  pending.fetch_add(1, std::memory_order_release);
+  task_signal.Notify();
+}
+
+void TaskPool::ParallelFor(int count, int max_lanes, const std::function<void(int index, int lane)>& fn) {
+  auto lanes = std::min({max_lanes, count, NumWorkers() + 1});
+  if (lanes <= 1) {
+    for (int i = 0; i < count; ++i) fn(i, 0);
+    return;
+  }
+
+  // Shared with lanes that may start after the caller returned; those claim no index and never
+  // touch fn
+  struct State {
+    int count = 0;
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    Signal finished;
+  };
+  auto state = std::make_shared<State>();
+  state->count = count;
+
+  auto run_lane = [state, &fn](int lane) {
+    for (int i = state->next.fetch_add(1); i < state->count; i = state->next.fetch_add(1)) {
+      fn(i, lane);
+      if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == state->count)
+        state->finished.Notify();
+    }
+  };
+
+  for (int lane = 1; lane < lanes; ++lane)
+    Submit([run_lane, lane] { run_lane(lane); });
+  run_lane(0);
+
+  // Only indices already claimed by running lanes are left
+  while (true) {
+    auto seen = state->finished.Sequence();
+    if (state->done.load(std::memory_order_acquire) == count)
+      break;
+    state->finished.Wait(seen, 10);
+  }
+}
+
+void TaskPool::Loop(int index) {
+  current_pool = this;
+  current_worker = index;
+  TraceRecorder::Instance().SetThreadName("task_worker");
+
+  std::function<void()> task;
+  while (running.load(std::memory_order_acquire)) {
+    auto seen = task_signal.Sequence();
+    if (Pop(index, task) || Steal(index, task)) {
+      pending.fetch_sub(1, std::memory_order_relaxed);
+      task();
+      task = nullptr;
+      continue;
+    }
+    // A task counted but not pushed yet, or pushed after the sequence was read
+    if (pending.load(std::memory_order_acquire) > 0)
+      continue;
+    task_signal.Wait(seen, 100);
+  }
+}
+
+bool TaskPool::Pop(int index, std::function<void()>& task) {
+  auto& queue = *queues[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool TaskPool::Steal(int thief, std::function<void()>& task) {
+  auto count = static_cast<int>(queues.size());
+  for (int i = 1; i < count; ++i) {
+    auto& queue = *queues[(thief + i) % count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+} // namespace vc
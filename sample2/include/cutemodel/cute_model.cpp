@@ -50,6 +50,21 @@ CuteModel& CuteModel::setUseGPU(bool use) &{
   return *this;
 }
 
+CuteModel& CuteModel::setOpEventCallback(OpEventCallback callback) & {
+  pImpl->setOpEventCallback(std::move(callback));
+  return *this;
+}
+
+CuteModel& CuteModel::setInputDims(int index, std::vector<int> dims) & {
+  pImpl->setInputDims(index, std::move(dims));
+  return *this;
+}
+
+CuteModel& CuteModel::shareCpuBackend(CuteModel& other) & {
+  pImpl->shareCpuBackend(*other.pImpl);
+  return *this;
+}
+
 void CuteModel::build() {
   return pImpl->build();
 }
@@ -62,6 +77,10 @@ void CuteModel::setInputInner(int index, const void *data) {
   return pImpl->setInput(index, data);
 }
 
+void* CuteModel::inputData(int index) {
+  return pImpl->inputData(index);
+}
+
 void CuteModel::invoke() {
   input_index = 0;
   return pImpl->invoke();
@@ -95,6 +114,22 @@ std::size_t CuteModel::outputBytes(int index) const {
   return pImpl->outputBytes(index);
 }
 
+std::size_t CuteModel::modelBytes() const {
+  return pImpl->modelBytes();
+}
+
+std::size_t CuteModel::arenaBytes() const {
+  return pImpl->arenaBytes(kTfLiteArenaRw);
+}
+
+std::size_t CuteModel::persistentArenaBytes() const {
+  return pImpl->arenaBytes(kTfLiteArenaRwPersistent);
+}
+
+std::vector<std::string> CuteModel::executionPlan() const {
+  return pImpl->executionPlan();
+}
+
 std::string CuteModel::summarize() const {
   return pImpl->summarize();
 }
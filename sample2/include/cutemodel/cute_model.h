@@ -6,6 +6,7 @@
 #define CUTE_MODEL_H_
 
 #include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,9 @@ struct Tensor {};
 std::string tensorName(const Tensor* tensor);
 std::vector<int> tensorDims(const Tensor* tensor);
 
+// Called when an operator starts (begin = true) and when it finishes. tag is the operator name.
+using OpEventCallback = std::function<void(const char* tag, bool begin)>;
+
 // Pimpl and builder pattern
 
 class CuteModel {
@@ -41,6 +45,13 @@ class CuteModel {
 
   CuteModel& setNumThreads(int num) &;
   CuteModel& setUseGPU(bool use) &;
+  CuteModel& setOpEventCallback(OpEventCallback callback) &;
+  // Resizes an input tensor, e.g. to a batch of N. Applied by build() and kept across rebuilds.
+  CuteModel& setInputDims(int index, std::vector<int> dims) &;
+  // Runs the CPU kernels XNNPACK does not take on the backend context of other, sharing its thread
+  // pool and scratch buffers. The two models must not invoke at the same time. An interpreter that is
+  // already built is rebuilt onto the shared context, other included.
+  CuteModel& shareCpuBackend(CuteModel& other) &;
 
   void build();
   bool isBuilt() const;
@@ -48,6 +59,9 @@ class CuteModel {
   template<class Input>                   void setInput(const Input input);
   template<class Input, class ...Inputs>  void setInput(const Input input, const Inputs ...inputs);
 
+  // Input tensor buffer, for writing inputs in place instead of copying with setInput
+  void* inputData(int index);
+
   template<typename T> std::vector<T> getOutput(int index) const;
   void copyOutput(int index, void* dst) const;
 
@@ -65,6 +79,15 @@ class CuteModel {
 
   std::size_t outputBytes(int index) const;
 
+  // Size of the model flatbuffer, and of the tensor arenas planned by build() (0 before it)
+  std::size_t modelBytes() const;
+  std::size_t arenaBytes() const;
+  std::size_t persistentArenaBytes() const;
+
+  // Nodes the interpreter runs after build(), by operator name; a delegated partition is one node
+  // named after its delegate, e.g. TfLiteXNNPackDelegate
+  std::vector<std::string> executionPlan() const;
+
   std::string summarize() const;
 };
 
@@ -12,45 +12,112 @@
 //#include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/schema/schema_generated.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <sstream>
 #include <vector>
 #include <string>
+#include <utility>
 
 namespace cute {
 
+// Forwards operator invoke events of the interpreter to an OpEventCallback
+class OpProfiler : public tflite::Profiler {
+ public:
+  explicit OpProfiler(OpEventCallback callback) : callback(std::move(callback)) {}
+
+  uint32_t BeginEvent(const char* tag, EventType event_type, int64_t, int64_t) override {
+    if (event_type != EventType::OPERATOR_INVOKE_EVENT &&
+        event_type != EventType::DELEGATE_OPERATOR_INVOKE_EVENT)
+      return 0;
+    tags.push_back(tag);
+    callback(tag, true);
+    return static_cast<uint32_t>(tags.size());
+  }
+
+  void EndEvent(uint32_t event_handle) override {
+    if (event_handle == 0 || event_handle > tags.size())
+      return;
+    callback(tags[event_handle - 1], false);
+    tags.resize(event_handle - 1);
+  }
+
+ private:
+  OpEventCallback callback;
+  std::vector<const char*> tags;
+};
+
 class CuteModel::Impl {
  public:
   Impl() = default;
 
   void loadBuffer(const void *buffer, size_t bufferSize) {
     model = tflite::FlatBufferModel::BuildFromBuffer(static_cast<const char *>(buffer), bufferSize);
-    tflite::InterpreterBuilder builder(*model, resolver);
-    if (builder(&interpreter) != kTfLiteOk) {
-      assert(((void)"Failed to build Tensorflow Lite interpreter", false));
-    }
-    interpreter->AllocateTensors();
+    createInterpreter();
   }
 
   void loadFile(const std::string& path) {
     model = tflite::FlatBufferModel::BuildFromFile(path.c_str());
-    tflite::InterpreterBuilder builder(*model, resolver);
-    if (builder(&interpreter) != kTfLiteOk) {
-      assert(((void)"Failed to build Tensorflow Lite interpreter", false));
-    }
-    interpreter->AllocateTensors();
+    createInterpreter();
   }
 
+  // The XNNPACK delegate takes its thread count from the InterpreterBuilder and ignores
+  // Interpreter::SetNumThreads, so the interpreter is rebuilt with the new count.
   void setNumThreads(int num) {
-    interpreter->SetNumThreads(num);
+    if (num == num_threads)
+      return;
+    num_threads = num;
+    createInterpreter();
+  }
+
+  void setOpEventCallback(OpEventCallback callback) {
+    if (callback) {
+      profiler = std::make_unique<OpProfiler>(std::move(callback));
+      interpreter->SetProfiler(profiler.get());
+    } else {
+      interpreter->SetProfiler(nullptr);
+      profiler.reset();
+    }
+  }
+
+  void setInputDims(int index, std::vector<int> dims) {
+    input_dims.erase(std::remove_if(input_dims.begin(), input_dims.end(),
+                                    [index](const auto& entry) { return entry.first == index; }),
+                     input_dims.end());
+    input_dims.emplace_back(index, std::move(dims));
+    allocated = false;
+  }
+
+  // The CPU backend (ruy's thread pool and its per-thread scratch) lives in the context, which
+  // outlives the interpreter and is kept across rebuilds.
+  void shareCpuBackend(Impl& other) {
+    if (other.cpu_backend == nullptr) {
+      other.cpu_backend = std::make_shared<tflite::ExternalCpuBackendContext>();
+      other.rebindCpuBackend();
+    }
+    cpu_backend = other.cpu_backend;
+    rebindCpuBackend();
   }
 
   void setUseGPU() {
     // We currently do not use GPU in Android and Web
   }
 
+  // Inputs are resized before the first AllocateTensors, where the lazily applied XNNPACK delegate
+  // plans for the final shapes.
   void build() {
+    if (interpreter != nullptr && !allocated) {
+      for (const auto& [index, dims] : input_dims)
+        interpreter->ResizeInputTensor(interpreter->inputs()[index], dims);
+      interpreter->AllocateTensors();
+      allocated = true;
+    }
   }
 
   bool isBuilt() const noexcept {
@@ -62,6 +129,10 @@ class CuteModel::Impl {
     std::memcpy(tensor->data.data, data, tensor->bytes);
   }
 
+  void* inputData(int index) {
+    return interpreter->input_tensor(index)->data.data;
+  }
+
   void copyOutput(int index, void* dst) {
     auto tensor = interpreter->output_tensor(index);
     std::memcpy(dst, tensor->data.data, tensor->bytes);
@@ -111,6 +182,48 @@ class CuteModel::Impl {
     return interpreter->output_tensor(index)->bytes;
   }
 
+  std::size_t modelBytes() const {
+    auto allocation = model != nullptr ? model->allocation() : nullptr;
+    return allocation != nullptr ? allocation->bytes() : 0;
+  }
+
+  // The arena planner is not public, so the arena size is the span its plan placed the tensors of
+  // one allocation type in, over all subgraphs. Buffers reused by the planner are counted once.
+  std::size_t arenaBytes(TfLiteAllocationType type) const {
+    if (interpreter == nullptr || !allocated)
+      return 0;
+
+    std::size_t total = 0;
+    for (size_t i = 0; i < interpreter->subgraphs_size(); ++i) {
+      auto* subgraph = interpreter->subgraph(static_cast<int>(i));
+      uintptr_t lo = UINTPTR_MAX, hi = 0;
+      for (size_t t = 0; t < subgraph->tensors_size(); ++t) {
+        auto* tensor = subgraph->tensor(static_cast<int>(t));
+        if (tensor->allocation_type != type || tensor->data.raw == nullptr)
+          continue;
+        auto begin = reinterpret_cast<uintptr_t>(tensor->data.raw);
+        lo = std::min(lo, begin);
+        hi = std::max(hi, begin + tensor->bytes);
+      }
+      if (hi > lo)
+        total += hi - lo;
+    }
+    return total;
+  }
+
+  std::vector<std::string> executionPlan() const {
+    std::vector<std::string> names;
+    if (interpreter == nullptr)
+      return names;
+    for (auto index : interpreter->execution_plan()) {
+      const auto& registration = interpreter->node_and_registration(index)->second;
+      auto code = static_cast<tflite::BuiltinOperator>(registration.builtin_code);
+      names.emplace_back(registration.custom_name != nullptr ? registration.custom_name
+                                                             : tflite::EnumNameBuiltinOperator(code));
+    }
+    return names;
+  }
+
   std::string summarize() const {
     if (interpreter == nullptr)
       return "Interpreter is not built.";
@@ -151,9 +264,48 @@ class CuteModel::Impl {
   }
 
  private:
+  // Tensors are allocated by build(), after the thread count is final, so the delegate packs its
+  // weights only once.
+  void createInterpreter() {
+    tflite::InterpreterBuilder builder(*model, resolver);
+    if (builder(&interpreter, num_threads) != kTfLiteOk) {
+      assert(((void)"Failed to build Tensorflow Lite interpreter", false));
+    }
+    allocated = false;
+    if (profiler != nullptr)
+      interpreter->SetProfiler(profiler.get());
+    if (cpu_backend != nullptr)
+      attachCpuBackend();
+  }
+
+  // Kernels take the context in Prepare, so an allocated interpreter is rebuilt rather than only
+  // given the new context
+  void rebindCpuBackend() {
+    if (interpreter == nullptr)
+      return;
+    if (!allocated) {
+      attachCpuBackend();
+      return;
+    }
+    createInterpreter();
+    build();
+  }
+
+  // SetNumThreads sizes the context's pool for this interpreter again
+  void attachCpuBackend() {
+    interpreter->SetExternalContext(kTfLiteCpuBackendContext, cpu_backend.get());
+    interpreter->SetNumThreads(num_threads);
+  }
+
   std::unique_ptr<tflite::FlatBufferModel> model;
   tflite::ops::builtin::BuiltinOpResolver resolver;
+  // Declared before the interpreter, which refers to it until destroyed
+  std::shared_ptr<tflite::ExternalCpuBackendContext> cpu_backend;
   std::unique_ptr<tflite::Interpreter> interpreter;
+  std::unique_ptr<OpProfiler> profiler;
+  std::vector<std::pair<int, std::vector<int>>> input_dims;
+  int num_threads = -1;
+  bool allocated = false;
 };
 
 }
@@ -0,0 +1,55 @@
+#include "detector/batch_face_detector.h"
+
+#include <algorithm>
+
+#include "concurrent/task_pool.h"
+#include "profile/memory_report.h"
+#include "profile/trace_recorder.h"
+#include "vccc/log.hpp"
+
+namespace vc {
+
+BatchFaceDetector::BatchFaceDetector(int num_workers) {
+  num_workers = std::max(num_workers, 1);
+
+  auto heap_before = HeapStats::Read().in_use;
+  workers.emplace_back(std::make_unique<BlazeFaceWrapper>(1));
+  auto heap_after = HeapStats::Read().in_use;
+  auto worker_bytes = heap_after > heap_before ? heap_after - heap_before : 0;
+
+  auto extra_workers = MemoryBudget::Instance().Fit(num_workers - 1, worker_bytes, 0);
+  if (extra_workers < num_workers - 1)
+    LOGD("Batch face detector: ", extra_workers + 1, " of ", num_workers, " workers fit the memory budget");
+  for (int i = 0; i < extra_workers; ++i)
+    workers.emplace_back(std::make_unique<BlazeFaceWrapper>(1));
+}
+
+int BatchFaceDetector::NumWorkers() const {
+  return static_cast<int>(workers.size());
+}
+
+MemoryReport BatchFaceDetector::MemoryUsage() const {
+  auto report = workers[0]->MemoryUsage();
+  for (size_t i = 1; i < workers.size(); ++i) {
+    auto worker = workers[i]->MemoryUsage();
+    report.arena_bytes += worker.arena_bytes;
+    report.persistent_arena_bytes += worker.persistent_arena_bytes;
+    report.image_scratch_bytes += worker.image_scratch_bytes;
+  }
+  return report;
+}
+
+void BatchFaceDetector::Detect(const ImageDesc* images, int count, FaceResult* results) {
+  // A lane runs one call at a time, so it owns the wrapper of the same index
+  TaskPool::Instance().ParallelFor(count, NumWorkers(), [&](int i, int lane) {
+    ScopedTrace trace("detectImage", "api");
+    auto [roi, angle] = workers[lane]->Execute(images[i], 0);
+    auto& result = results[i];
+    result.found = !roi.empty();
+    result.roi = std::move(roi);
+    result.angle = angle;
+    result.frame_id = static_cast<uint64_t>(i);
+  });
+}
+
+} // namespace vc
@@ -0,0 +1,58 @@
+#ifndef WASMSAMPLE_DETECTOR_CASCADE_DETECTOR_H_
+#define WASMSAMPLE_DETECTOR_CASCADE_DETECTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "detector/cascade_stage.h"
+#include "image/image_desc.h"
+
+namespace vc {
+
+struct CascadeResult {
+  bool found = false;
+  bool detector_skipped = false;  // the crop came from the previous frame's landmarks
+  ROI crop_roi;                   // the ROI the stage cropped
+  CascadeStageResult stage;
+};
+
+// BlazeFace followed by a CascadeStage on the detected face.
+//
+// While the stage scores at least track_score, the next frame skips the detector and crops around
+// the previous landmarks instead, as face mesh trackers do. Both models read the frame in place
+// and their raw outputs go through one scratch buffer, so a frame allocates nothing once the
+// buffers have grown.
+class CascadeDetector {
+ public:
+  // track_score > 1 always runs the detector
+  CascadeDetector(const CascadeStageOptions& stage_options, float track_score = 0.9f, int num_threads = 1);
+
+  CascadeResult Detect(const ImageDesc& frame);
+
+  // Forgets the tracked face, the next frame runs the detector
+  void Reset();
+
+  // Frames that ran the detector / skipped it
+  uint64_t DetectorRuns() const { return detector_runs; }
+  uint64_t DetectorSkips() const { return detector_skips; }
+
+ private:
+  Detection RunDetector(const ImageDesc& frame);
+
+  BlazeFaceWrapper face_wrapper;
+  CascadeStage stage;
+  float track_score;
+
+  std::vector<float> scratch;
+  bool tracking = false;
+  ROI tracked_roi;
+  Angle angle = 0;
+
+  uint64_t detector_runs = 0;
+  uint64_t detector_skips = 0;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_CASCADE_DETECTOR_H_
@@ -0,0 +1,19 @@
+#ifndef WASMSAMPLE_DETECTOR_FACE_RESULT_H_
+#define WASMSAMPLE_DETECTOR_FACE_RESULT_H_
+
+#include <cstdint>
+
+#include "blaze_face_wrapper.h"
+
+namespace vc {
+
+struct FaceResult {
+  ROI roi;
+  Angle angle = 0;
+  uint64_t frame_id = 0;
+  bool found = false;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_FACE_RESULT_H_
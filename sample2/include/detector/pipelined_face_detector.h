@@ -0,0 +1,140 @@
+#ifndef WASMSAMPLE_DETECTOR_PIPELINED_FACE_DETECTOR_H_
+#define WASMSAMPLE_DETECTOR_PIPELINED_FACE_DETECTOR_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "concurrent/signal.h"
+#include "concurrent/spsc_queue.h"
+#include "detector/face_result.h"
+#include "image/image_desc.h"
+#include "profile/detector_stats.h"
+
+namespace vc {
+
+// Runs the stages of BlazeFaceWrapper::Run concurrently on successive frames:
+//
+//   Submit (copy/convert) -> PreProcess -> invoke -> PostProcess/Realign -> Poll
+//
+// The caller's thread does the copy, the other stages get a thread each and hand frames to the
+// next stage through bounded SPSC queues. Frames live in a fixed pool of kDepth contexts, so
+// nothing is allocated per frame and at most kDepth frames are in flight. Once the pipeline is
+// full, throughput is bound by the slowest stage instead of the sum of all stages.
+//
+// The rotation prior of a frame is the angle of the latest finished frame, which lags a few frames
+// behind compared to BlazeFaceWrapper::Execute.
+//
+// With a MemoryBudget set, Start() uses only as many contexts as fit in it (at least one).
+//
+// On Emscripten the stage threads come from the pthread pool, next to the TaskPool's workers that
+// PreProcess uses: configure the TaskPool to at most PTHREAD_POOL_SIZE - kStageThreads workers
+// before its first use.
+class PipelinedFaceDetector {
+ public:
+  static constexpr size_t kDepth = 4;
+
+  // Threads started by Start(), the invoke stage's interpreter runs on one of them
+  static constexpr int kStageThreads = 3;
+
+  // Frame copy size assumed per context by the memory budget before the first frame (720p RGBA)
+  static constexpr size_t kFrameBytesEstimate = 1280 * 720 * 4;
+
+  struct Stats {
+    uint64_t submitted = 0;
+    uint64_t processed = 0;
+    uint64_t rejected = 0;        // Submit() found no free frame context
+    uint64_t results_dropped = 0; // results not polled in time
+  };
+
+  PipelinedFaceDetector();
+  ~PipelinedFaceDetector();
+
+  PipelinedFaceDetector(const PipelinedFaceDetector&) = delete;
+  PipelinedFaceDetector& operator = (const PipelinedFaceDetector&) = delete;
+
+  void Start();
+  void Stop();
+  bool IsRunning() const;
+
+  // Copies a frame into a free context and returns its frame id. Waits up to timeout_ms for a
+  // context to be recycled and returns 0 if none became free. Keep timeout_ms at 0 on the browser
+  // main thread.
+  uint64_t Submit(const ImageDesc& image, double timeout_ms = 0);
+
+  // Returns true and fills result with the oldest result not polled yet.
+  bool Poll(FaceResult& result);
+
+  // Waits up to timeout_ms for a result
+  bool Poll(FaceResult& result, double timeout_ms);
+
+  Stats GetStats() const;
+
+  // Per-stage latency of the finished frames. The stages overlap, so the total is a frame's
+  // latency rather than the time per frame.
+  DetectorStats SnapshotDetectorStats(bool reset);
+
+  // Contexts in use since the last Start()
+  size_t Depth() const;
+
+  // The detector's BlazeFaceWrapper report plus the frame contexts in use
+  MemoryReport MemoryUsage() const;
+
+ private:
+  struct FrameContext {
+    uint64_t id = 0;
+    std::vector<unsigned char> pixels;
+    ImageDesc image;
+    Letterbox letterbox;
+    Angle angle = 0;
+    std::vector<float> input;
+    std::vector<float> boxes;
+    std::vector<float> scores;
+    StageTimes times;
+  };
+
+  using ContextQueue = SpscQueue<FrameContext*, kDepth>;
+
+  struct Channel {
+    ContextQueue queue;
+    Signal signal;
+  };
+
+  // Pops from input, processes and pushes to output until Stop()
+  template<typename Process>
+  void StageLoop(const char* thread_name, Channel& input, Channel& output, Process process);
+
+  void PreProcess(FrameContext& ctx);
+  void Invoke(FrameContext& ctx);
+  void PostProcess(FrameContext& ctx);
+
+  BlazeFaceWrapper face_wrapper;
+  std::atomic<Angle> prior_angle{0};
+
+  std::array<FrameContext, kDepth> contexts;
+  size_t depth = kDepth;
+  size_t context_tensor_bytes = 0;
+  std::atomic<size_t> frame_bytes{0};  // largest frame copy so far
+  Channel free_contexts;
+  Channel submitted_frames;
+  Channel preprocessed_frames;
+  Channel inferred_frames;
+
+  SpscQueue<FaceResult, kDepth * 4> results;
+  Signal result_signal;
+
+  std::vector<std::thread> workers;
+  std::atomic<bool> running{false};
+
+  std::atomic<uint64_t> submitted{0};
+  std::atomic<uint64_t> processed{0};
+  std::atomic<uint64_t> rejected{0};
+  std::atomic<uint64_t> results_dropped{0};
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_PIPELINED_FACE_DETECTOR_H_
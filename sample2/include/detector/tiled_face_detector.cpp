@@ -0,0 +1,238 @@
+#include "detector/tiled_face_detector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "concurrent/task_pool.h"
+#include "image/fused_sampler.h"
+#include "model/model_reader.h"
+#include "profile/clock.h"
+#include "profile/trace_recorder.h"
+
+namespace vc {
+
+namespace {
+
+// Smallest face box the model finds reliably, in model pixels
+constexpr float kMinFaceModelPx = 20.f;
+constexpr float kLevelStep = 2.f;
+// A box this close to a shared tile edge counts as cut by it
+constexpr float kEdgeMargin = 2.f;
+
+float IoU(const std::array<float, 4>& a, const std::array<float, 4>& b) {
+  auto w = std::min(a[2], b[2]) - std::max(a[0], b[0]);
+  auto h = std::min(a[3], b[3]) - std::max(a[1], b[1]);
+  if (w <= 0 || h <= 0)
+    return 0;
+  auto inter = w * h;
+  auto area_a = (a[2] - a[0]) * (a[3] - a[1]), area_b = (b[2] - b[0]) * (b[3] - b[1]);
+  return inter / (area_a + area_b - inter);
+}
+
+} // namespace
+
+TiledFaceDetector::TiledFaceDetector(const TileOptions& options, int num_workers, int num_threads)
+  : options(options) {
+  this->options.batch_size = std::max(this->options.batch_size, 1);
+  this->options.overlap = std::clamp(this->options.overlap, 0, Model::kInputWidth / 2);
+  this->options.min_face = std::max(this->options.min_face, 1);
+
+  auto model_data = ModelReader::ReadBlazeFaceModel();
+  for (int i = 0; i < std::max(num_workers, 1); ++i) {
+    auto worker = std::make_unique<Worker>();
+    worker->model.loadBuffer(model_data.byte, model_data.size)
+                 .setNumThreads(num_threads)
+                 .setInputDims(0, {this->options.batch_size, Model::kInputHeight, Model::kInputWidth, 3})
+                 .build();
+    workers.emplace_back(std::move(worker));
+  }
+
+  auto& model = workers[0]->model;
+  for (int i = 0, count = static_cast<int>(model.outputTensorCount()); i < count; ++i) {
+    const auto& tensor = model.outputTensor(i);
+    if (cute::tensorName(tensor) == "regressors") r_index = i;
+    if (cute::tensorName(tensor) == "classificators") c_index = i;
+  }
+  batch_major = model.outputTensorDims(c_index)[0] == this->options.batch_size;
+  assert(((void)"Tile batch does not match the model geometry",
+          model.outputBytes(c_index) == this->options.batch_size * Decoder::kNumAnchors * sizeof(float)));
+
+  for (auto& worker : workers) {
+    worker->boxes.resize(model.outputBytes(r_index) / sizeof(float));
+    worker->scores.resize(model.outputBytes(c_index) / sizeof(float));
+  }
+}
+
+std::vector<FaceDetection> TiledFaceDetector::Detect(const ImageDesc& image) {
+  ScopedTrace trace("detectTiled", "api");
+  auto start_time = NowMs();
+  last_run = {};
+  if (image.empty())
+    return {};
+
+  auto tiles = MakeTiles(image.width, image.height, last_run.levels);
+  const auto batch_size = options.batch_size;
+  const auto tile_count = static_cast<int>(tiles.size());
+  const auto batch_count = (tile_count + batch_size - 1) / batch_size;
+
+  for (auto& worker : workers)
+    worker->candidates.clear();
+  TaskPool::Instance().ParallelFor(batch_count, NumWorkers(), [&](int batch, int lane) {
+    auto first = batch * batch_size;
+    RunBatch(*workers[lane], image, tiles.data() + first, std::min(batch_size, tile_count - first));
+  });
+
+  std::vector<Candidate> candidates;
+  for (auto& worker : workers)
+    candidates.insert(candidates.end(), worker->candidates.begin(), worker->candidates.end());
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+  // Weighted NMS: a face is the score-weighted mean of the candidates overlapping its best one
+  std::vector<FaceDetection> faces;
+  std::vector<bool> merged(candidates.size(), false);
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (merged[i])
+      continue;
+
+    Candidate sum;
+    float weight = 0;
+    for (size_t j = i; j < candidates.size(); ++j) {
+      if (merged[j] || IoU(candidates[i].box, candidates[j].box) < options.iou_threshold)
+        continue;
+      merged[j] = true;
+      const auto& c = candidates[j];
+      for (int k = 0; k < 4; ++k) sum.box[k] += c.box[k] * c.score;
+      for (int k = 0; k < Decoder::kNumKeypoints; ++k) {
+        sum.keypoints[k].x += c.keypoints[k].x * c.score;
+        sum.keypoints[k].y += c.keypoints[k].y * c.score;
+      }
+      weight += c.score;
+    }
+
+    FaceDetection face;
+    face.score = candidates[i].score;
+    for (auto value : sum.box)
+      face.roi.push_back(static_cast<int>(std::round(value / weight)));
+    for (const auto& keypoint : sum.keypoints)
+      face.landmarks.emplace_back(keypoint.x / weight, keypoint.y / weight);
+    face.angle = BlazeFaceWrapper::CalculateFaceAngleFromLandmarks(face.landmarks);
+    faces.push_back(std::move(face));
+  }
+
+  last_run.tiles = tile_count;
+  last_run.invokes = batch_count;
+  last_run.candidates = static_cast<int>(candidates.size());
+  last_run.ms = NowMs() - start_time;
+  return faces;
+}
+
+std::vector<TiledFaceDetector::Tile> TiledFaceDetector::MakeTiles(int width, int height, int& levels) const {
+  const auto side = static_cast<float>(Model::kInputWidth);
+  const auto full_scale = static_cast<float>(std::max(width, height)) / side;
+
+  std::vector<Tile> tiles;
+  levels = 0;
+  for (auto scale = std::max(1.f, static_cast<float>(options.min_face) / kMinFaceModelPx);; scale *= kLevelStep) {
+    ++levels;
+    if (scale >= full_scale) {
+      // The whole image, letterboxed like BlazeFaceWrapper does
+      Tile tile;
+      tile.scale = full_scale;
+      tile.x = (static_cast<float>(width) - side * full_scale) / 2;
+      tile.y = (static_cast<float>(height) - side * full_scale) / 2;
+      tiles.push_back(tile);
+      break;
+    }
+
+    // Tiles spread evenly from border to border, overlapping by at least options.overlap
+    const auto tile_side = side * scale;
+    const auto step = (side - static_cast<float>(options.overlap)) * scale;
+    auto count = [&](int length) {
+      return length > tile_side ? static_cast<int>(std::ceil((static_cast<float>(length) - tile_side) / step)) + 1 : 1;
+    };
+    auto origin = [&](int length, int index, int n) {
+      auto room = static_cast<float>(length) - tile_side;
+      return n > 1 ? room * static_cast<float>(index) / static_cast<float>(n - 1) : room / 2;
+    };
+
+    const auto nx = count(width), ny = count(height);
+    for (int iy = 0; iy < ny; ++iy) {
+      for (int ix = 0; ix < nx; ++ix) {
+        Tile tile;
+        tile.scale = scale;
+        tile.x = origin(width, ix, nx);
+        tile.y = origin(height, iy, ny);
+        tile.shared = {ix > 0, iy > 0, ix + 1 < nx, iy + 1 < ny};
+        tiles.push_back(tile);
+      }
+    }
+
+    if (options.levels > 0 && levels == options.levels)
+      break;
+  }
+  return tiles;
+}
+
+void TiledFaceDetector::RunBatch(Worker& worker, const ImageDesc& image, const Tile* tiles, int count) {
+  ScopedTrace trace("tileBatch", "stage");
+  auto* input = static_cast<float*>(worker.model.inputData(0));
+  const auto plane = static_cast<size_t>(Model::kInputWidth) * Model::kInputHeight * 3;
+
+  // Model pixel centers to image pixel centers. Inputs past count keep older tiles and are ignored.
+  TaskPool::Instance().ParallelFor(count, count, [&](int i, int) {
+    const auto& tile = tiles[i];
+    AffineMap map;
+    map.m[0] = tile.scale;
+    map.m[1] = 0;
+    map.m[2] = tile.x + 0.5f * tile.scale - 0.5f;
+    map.m[3] = 0;
+    map.m[4] = tile.scale;
+    map.m[5] = tile.y + 0.5f * tile.scale - 0.5f;
+    SampleRGB(image, map, input + i * plane, Model::kInputWidth, Model::kInputHeight, Model::kInputScale,
+              Model::kInputOffset);
+  });
+
+  worker.model.invoke();
+  worker.model.copyOutput(r_index, worker.boxes.data());
+  worker.model.copyOutput(c_index, worker.scores.data());
+
+  std::vector<float> item_boxes(Decoder::kNumAnchors * Decoder::kBoxSize), item_scores(Decoder::kNumAnchors);
+  for (int i = 0; i < count; ++i) {
+    Decoder::Unbatch(worker.boxes.data(), options.batch_size, i, Decoder::kBoxSize, batch_major, item_boxes.data());
+    Decoder::Unbatch(worker.scores.data(), options.batch_size, i, 1, batch_major, item_scores.data());
+    DecodeTile(tiles[i], item_boxes.data(), item_scores.data(), worker.candidates);
+  }
+}
+
+void TiledFaceDetector::DecodeTile(const Tile& tile, const float* boxes, const float* scores,
+                                   std::vector<Candidate>& out) const {
+  // Scores are logits, compared before the sigmoid
+  const auto threshold = options.score_threshold;
+  const auto min_logit = std::log(threshold / (1 - threshold));
+  const auto width = static_cast<float>(Model::kInputWidth), height = static_cast<float>(Model::kInputHeight);
+
+  for (int i = 0; i < Decoder::kNumAnchors; ++i) {
+    if (scores[i] < min_logit)
+      continue;
+
+    auto decoded = Decoder::Decode(boxes, i);
+    const auto& box = decoded.box;
+    if ((tile.shared[0] && box[0] < kEdgeMargin) || (tile.shared[1] && box[1] < kEdgeMargin)
+        || (tile.shared[2] && box[2] > width - kEdgeMargin) || (tile.shared[3] && box[3] > height - kEdgeMargin))
+      continue;
+
+    Candidate candidate;
+    candidate.score = 1 / (1 + std::exp(-scores[i]));
+    candidate.box = {tile.x + box[0] * tile.scale, tile.y + box[1] * tile.scale,
+                     tile.x + box[2] * tile.scale, tile.y + box[3] * tile.scale};
+    for (int k = 0; k < Decoder::kNumKeypoints; ++k) {
+      candidate.keypoints[k].x = tile.x + decoded.keypoints[k].x * tile.scale;
+      candidate.keypoints[k].y = tile.y + decoded.keypoints[k].y * tile.scale;
+    }
+    out.push_back(candidate);
+  }
+}
+
+} // namespace vc
@@ -0,0 +1,93 @@
+#ifndef WASMSAMPLE_DETECTOR_TILED_FACE_DETECTOR_H_
+#define WASMSAMPLE_DETECTOR_TILED_FACE_DETECTOR_H_
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "blaze_face_wrapper.h"
+#include "cutemodel/cute_model.h"
+#include "image/image_desc.h"
+#include "model/ssd_model.h"
+
+namespace vc {
+
+struct TileOptions {
+  int min_face = 20;            // smallest face to find in image pixels, sets the scale of the finest tiles
+  int levels = 0;               // pyramid levels, each twice as coarse, up to the whole image; 0 for all
+  int overlap = 48;             // tile overlap in model pixels, faces up to this size are never cut
+  int batch_size = 8;           // tiles per invoke
+  float score_threshold = 0.5f;
+  float iou_threshold = 0.3f;   // NMS across tiles and levels
+};
+
+// What the last Detect did
+struct TileRunStats {
+  int levels = 0;
+  int tiles = 0;
+  int invokes = 0;
+  int candidates = 0;  // faces before NMS
+  double ms = 0;
+};
+
+// Finds every face in a large image, down to options.min_face pixels.
+//
+// The image is covered with overlapping model-sized tiles at the scale where a min_face face fills
+// the smallest box the model detects, then at coarser pyramid levels for faces too large for those
+// tiles, ending with the letterboxed whole image. Tiles are sampled straight from the frame (see
+// SampleRGB) into batched inputs, and faces are merged in image coordinates by NMS. A face touching
+// the edge a tile shares with its neighbor is dropped there, since the overlap shows it whole in
+// the neighbor or at a coarser level. Every level has a quarter of the tiles of the one before, so
+// the cost grows linearly with the image area.
+//
+// Each worker owns an interpreter with a batch of options.batch_size inputs. Batches are spread
+// over the workers on TaskPool lanes. Tiles are upright; rotated faces are not searched.
+class TiledFaceDetector {
+ public:
+  explicit TiledFaceDetector(const TileOptions& options = {}, int num_workers = 1, int num_threads = 1);
+
+  // Faces by descending score, in image pixels
+  std::vector<FaceDetection> Detect(const ImageDesc& image);
+
+  int NumWorkers() const { return static_cast<int>(workers.size()); }
+  const TileRunStats& LastRun() const { return last_run; }
+
+ private:
+  using Model = BlazeFaceShortRange;
+  using Decoder = SsdDecoder<Model>;
+
+  struct Tile {
+    float x = 0;
+    float y = 0;
+    float scale = 1;               // image pixels per model pixel
+    std::array<bool, 4> shared{};  // left, top, right and bottom edges lie inside the image
+  };
+
+  struct Candidate {
+    std::array<float, 4> box{};  // xmin, ymin, xmax, ymax
+    float score = 0;
+    std::array<AnchorCenter, Decoder::kNumKeypoints> keypoints{};
+  };
+
+  struct Worker {
+    cute::CuteModel model;
+    std::vector<float> boxes;
+    std::vector<float> scores;
+    std::vector<Candidate> candidates;
+  };
+
+  std::vector<Tile> MakeTiles(int width, int height, int& levels) const;
+  void RunBatch(Worker& worker, const ImageDesc& image, const Tile* tiles, int count);
+  void DecodeTile(const Tile& tile, const float* boxes, const float* scores, std::vector<Candidate>& out) const;
+
+  TileOptions options;
+  std::vector<std::unique_ptr<Worker>> workers;
+  int r_index = 0;
+  int c_index = 0;
+  bool batch_major = false;
+  TileRunStats last_run;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_DETECTOR_TILED_FACE_DETECTOR_H_
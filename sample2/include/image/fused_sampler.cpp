@@ -0,0 +1,171 @@
+#include "image/fused_sampler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+
+namespace vc {
+
+namespace {
+
+struct Tap {
+  int x0, x1;
+  int y0, y1;
+  float fx, fy;
+};
+
+inline Tap MakeTap(float x, float y, int width, int height) {
+  auto fx0 = std::floor(x);
+  auto fy0 = std::floor(y);
+  auto x0 = static_cast<int>(fx0);
+  auto y0 = static_cast<int>(fy0);
+
+  Tap tap;
+  tap.fx = x - fx0;
+  tap.fy = y - fy0;
+  tap.x0 = std::clamp(x0, 0, width - 1);
+  tap.x1 = std::clamp(x0 + 1, 0, width - 1);
+  tap.y0 = std::clamp(y0, 0, height - 1);
+  tap.y1 = std::clamp(y0 + 1, 0, height - 1);
+  return tap;
+}
+
+template<int Step>
+inline float Bilinear(const unsigned char* row0, const unsigned char* row1, const Tap& tap, int offset) {
+  float a = row0[tap.x0 * Step + offset];
+  float b = row0[tap.x1 * Step + offset];
+  float c = row1[tap.x0 * Step + offset];
+  float d = row1[tap.x1 * Step + offset];
+  float top = a + (b - a) * tap.fx;
+  float bottom = c + (d - c) * tap.fx;
+  return top + (bottom - top) * tap.fy;
+}
+
+template<int R, int G, int B, int Step>
+struct PackedFetch {
+  const unsigned char* data;
+  int stride;
+  int width;
+  int height;
+
+  inline void operator()(float x, float y, float* rgb) const {
+    auto tap = MakeTap(x, y, width, height);
+    auto row0 = data + tap.y0 * stride;
+    auto row1 = data + tap.y1 * stride;
+    rgb[0] = Bilinear<Step>(row0, row1, tap, R);
+    rgb[1] = Bilinear<Step>(row0, row1, tap, G);
+    rgb[2] = Bilinear<Step>(row0, row1, tap, B);
+  }
+};
+
+inline void YUVToRGB(float y, float u, float v, float* rgb) {
+  y = 1.164f * (y - 16.f);
+  u -= 128.f;
+  v -= 128.f;
+  rgb[0] = std::clamp(y + 1.596f * v, 0.f, 255.f);
+  rgb[1] = std::clamp(y - 0.813f * v - 0.391f * u, 0.f, 255.f);
+  rgb[2] = std::clamp(y + 2.018f * u, 0.f, 255.f);
+}
+
+// U and V either interleaved in one plane (Step = 2) or in separate planes (Step = 1)
+template<int Step>
+struct YUV420Fetch {
+  const unsigned char* y_plane;
+  const unsigned char* u_plane;
+  const unsigned char* v_plane;
+  int y_stride;
+  int u_stride;
+  int v_stride;
+  int width;
+  int height;
+
+  inline void operator()(float x, float y, float* rgb) const {
+    auto luma_tap = MakeTap(x, y, width, height);
+    auto luma = Bilinear<1>(y_plane + luma_tap.y0 * y_stride, y_plane + luma_tap.y1 * y_stride, luma_tap, 0);
+
+    // Chroma samples are centered between 2x2 luma samples
+    auto chroma_tap = MakeTap((x + 0.5f) * 0.5f - 0.5f, (y + 0.5f) * 0.5f - 0.5f, (width + 1) / 2, (height + 1) / 2);
+    auto u = Bilinear<Step>(u_plane + chroma_tap.y0 * u_stride, u_plane + chroma_tap.y1 * u_stride, chroma_tap, 0);
+    auto v = Bilinear<Step>(v_plane + chroma_tap.y0 * v_stride, v_plane + chroma_tap.y1 * v_stride, chroma_tap, 0);
+
+    YUVToRGB(luma, u, v, rgb);
+  }
+};
+
+template<typename Fetch>
+void SampleRows(const Fetch& fetch, int width, int height, const AffineMap& map,
+                float* dst, int dst_width, int row_begin, int row_end, float alpha, float beta) {
+  const auto x_max = static_cast<float>(width) - 0.5f;
+  const auto y_max = static_cast<float>(height) - 0.5f;
+
+  dst += static_cast<size_t>(row_begin) * dst_width * 3;
+  for (int v = row_begin; v < row_end; ++v) {
+    auto x = map.m[1] * static_cast<float>(v) + map.m[2];
+    auto y = map.m[4] * static_cast<float>(v) + map.m[5];
+    for (int u = 0; u < dst_width; ++u, x += map.m[0], y += map.m[3], dst += 3) {
+      if (x < -0.5f || y < -0.5f || x >= x_max || y >= y_max) {
+        dst[0] = dst[1] = dst[2] = beta;
+        continue;
+      }
+      float rgb[3];
+      fetch(x, y, rgb);
+      dst[0] = rgb[0] * alpha + beta;
+      dst[1] = rgb[1] * alpha + beta;
+      dst[2] = rgb[2] * alpha + beta;
+    }
+  }
+}
+
+template<int R, int G, int B, int Step>
+void SamplePacked(const ImageDesc& src, const AffineMap& map, float* dst, int dst_width, int row_begin, int row_end,
+                  float alpha, float beta) {
+  PackedFetch<R, G, B, Step> fetch{src.planes[0], src.strides[0], src.width, src.height};
+  SampleRows(fetch, src.width, src.height, map, dst, dst_width, row_begin, row_end, alpha, beta);
+}
+
+} // namespace
+
+void SampleRGB(const ImageDesc& src, const AffineMap& dst_to_src,
+               float* dst, int dst_width, int dst_height,
+               float alpha, float beta) {
+  SampleRGBRows(src, dst_to_src, dst, dst_width, 0, dst_height, alpha, beta);
+}
+
+void SampleRGBRows(const ImageDesc& src, const AffineMap& dst_to_src,
+                   float* dst, int dst_width, int row_begin, int row_end,
+                   float alpha, float beta) {
+  switch (src.format) {
+    case PixelFormat::kRGBA:
+      SamplePacked<0, 1, 2, 4>(src, dst_to_src, dst, dst_width, row_begin, row_end, alpha, beta);
+      break;
+    case PixelFormat::kBGRA:
+      SamplePacked<2, 1, 0, 4>(src, dst_to_src, dst, dst_width, row_begin, row_end, alpha, beta);
+      break;
+    case PixelFormat::kRGB:
+      SamplePacked<0, 1, 2, 3>(src, dst_to_src, dst, dst_width, row_begin, row_end, alpha, beta);
+      break;
+    case PixelFormat::kBGR:
+      SamplePacked<2, 1, 0, 3>(src, dst_to_src, dst, dst_width, row_begin, row_end, alpha, beta);
+      break;
+    case PixelFormat::kNV12:
+    case PixelFormat::kNV21: {
+      auto vu_order = src.format == PixelFormat::kNV21;
+      YUV420Fetch<2> fetch{src.planes[0],
+                           src.planes[1] + (vu_order ? 1 : 0),
+                           src.planes[1] + (vu_order ? 0 : 1),
+                           src.strides[0], src.strides[1], src.strides[1],
+                           src.width, src.height};
+      SampleRows(fetch, src.width, src.height, dst_to_src, dst, dst_width, row_begin, row_end, alpha, beta);
+      break;
+    }
+    case PixelFormat::kI420: {
+      YUV420Fetch<1> fetch{src.planes[0], src.planes[1], src.planes[2],
+                           src.strides[0], src.strides[1], src.strides[2],
+                           src.width, src.height};
+      SampleRows(fetch, src.width, src.height, dst_to_src, dst, dst_width, row_begin, row_end, alpha, beta);
+      break;
+    }
+  }
+}
+
+} // namespace vc
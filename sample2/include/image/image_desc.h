@@ -0,0 +1,148 @@
+#ifndef WASMSAMPLE_IMAGE_IMAGE_DESC_H_
+#define WASMSAMPLE_IMAGE_IMAGE_DESC_H_
+
+#include <cstring>
+#include <vector>
+
+namespace vc {
+
+// Values are part of the exported C API, do not reorder.
+enum class PixelFormat : int {
+  kRGBA = 0,
+  kBGRA = 1,
+  kRGB = 2,
+  kBGR = 3,
+  kNV12 = 4,  // Y plane + interleaved UV plane, 4:2:0
+  kNV21 = 5,  // Y plane + interleaved VU plane, 4:2:0
+  kI420 = 6,  // Y, U and V planes, 4:2:0
+};
+
+inline bool IsYUV(PixelFormat format) {
+  return format == PixelFormat::kNV12 || format == PixelFormat::kNV21 || format == PixelFormat::kI420;
+}
+
+// Bytes per pixel of packed formats, bytes per luma sample of planar ones.
+inline int BytesPerPixel(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::kRGBA:
+    case PixelFormat::kBGRA: return 4;
+    case PixelFormat::kRGB:
+    case PixelFormat::kBGR: return 3;
+    default: return 1;
+  }
+}
+
+inline int PlaneCount(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::kNV12:
+    case PixelFormat::kNV21: return 2;
+    case PixelFormat::kI420: return 3;
+    default: return 1;
+  }
+}
+
+struct PlaneSize {
+  int row_bytes;
+  int rows;
+};
+
+inline PlaneSize GetPlaneSize(PixelFormat format, int width, int height, int plane) {
+  if (plane == 0)
+    return {width * BytesPerPixel(format), height};
+  auto chroma_width = (width + 1) / 2;
+  auto chroma_height = (height + 1) / 2;
+  if (format == PixelFormat::kI420)
+    return {chroma_width, chroma_height};
+  return {chroma_width * 2, chroma_height};
+}
+
+// Non-owning view of an input frame.
+//
+// Packed formats use planes[0] only. NV12/NV21 use planes[0] (Y) and planes[1] (UV), I420 uses
+// all three. Strides are in bytes; a stride of 0 means tightly packed.
+struct ImageDesc {
+  PixelFormat format = PixelFormat::kRGBA;
+  int width = 0;
+  int height = 0;
+  const unsigned char* planes[3] = {nullptr, nullptr, nullptr};
+  int strides[3] = {0, 0, 0};
+
+  // Also true when a plane the format needs is missing
+  bool empty() const {
+    if (width <= 0 || height <= 0)
+      return true;
+    for (int i = 0; i < PlaneCount(format); ++i) {
+      if (planes[i] == nullptr)
+        return true;
+    }
+    return false;
+  }
+
+  static ImageDesc Packed(PixelFormat format, const unsigned char* data, int width, int height, int stride = 0) {
+    ImageDesc desc;
+    desc.format = format;
+    desc.width = width;
+    desc.height = height;
+    desc.planes[0] = data;
+    desc.strides[0] = stride > 0 ? stride : width * BytesPerPixel(format);
+    return desc;
+  }
+
+  static ImageDesc NV12(const unsigned char* y, const unsigned char* uv, int width, int height,
+                        int y_stride = 0, int uv_stride = 0, bool vu_order = false) {
+    ImageDesc desc;
+    desc.format = vu_order ? PixelFormat::kNV21 : PixelFormat::kNV12;
+    desc.width = width;
+    desc.height = height;
+    desc.planes[0] = y;
+    desc.planes[1] = uv;
+    desc.strides[0] = y_stride > 0 ? y_stride : width;
+    desc.strides[1] = uv_stride > 0 ? uv_stride : (width + 1) / 2 * 2;
+    return desc;
+  }
+
+  static ImageDesc I420(const unsigned char* y, const unsigned char* u, const unsigned char* v, int width, int height,
+                        int y_stride = 0, int u_stride = 0, int v_stride = 0) {
+    ImageDesc desc;
+    desc.format = PixelFormat::kI420;
+    desc.width = width;
+    desc.height = height;
+    desc.planes[0] = y;
+    desc.planes[1] = u;
+    desc.planes[2] = v;
+    desc.strides[0] = y_stride > 0 ? y_stride : width;
+    desc.strides[1] = u_stride > 0 ? u_stride : (width + 1) / 2;
+    desc.strides[2] = v_stride > 0 ? v_stride : (width + 1) / 2;
+    return desc;
+  }
+};
+
+// Copies src into buffer, tightly packed, and returns a view of the copy. An empty src gives an
+// empty view.
+inline ImageDesc CopyImage(const ImageDesc& src, std::vector<unsigned char>& buffer) {
+  if (src.empty())
+    return {};
+  auto plane_count = PlaneCount(src.format);
+
+  size_t total = 0;
+  for (int i = 0; i < plane_count; ++i) {
+    auto size = GetPlaneSize(src.format, src.width, src.height, i);
+    total += static_cast<size_t>(size.row_bytes) * size.rows;
+  }
+  buffer.resize(total);
+
+  ImageDesc dst = src;
+  auto out = buffer.data();
+  for (int i = 0; i < plane_count; ++i) {
+    auto size = GetPlaneSize(src.format, src.width, src.height, i);
+    dst.planes[i] = out;
+    dst.strides[i] = size.row_bytes;
+    for (int row = 0; row < size.rows; ++row, out += size.row_bytes)
+      std::memcpy(out, src.planes[i] + static_cast<size_t>(row) * src.strides[i], size.row_bytes);
+  }
+  return dst;
+}
+
+} // namespace vc
+
+#endif //WASMSAMPLE_IMAGE_IMAGE_DESC_H_
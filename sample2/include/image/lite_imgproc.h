@@ -0,0 +1,56 @@
+#ifndef WASMSAMPLE_IMAGE_LITE_IMGPROC_H_
+#define WASMSAMPLE_IMAGE_LITE_IMGPROC_H_
+
+#include "image/lite_mat.h"
+
+namespace vc {
+namespace lite {
+
+// The OpenCV imgproc functions used by BlazeFaceWrapper, same signatures and geometry.
+// 8-bit and float images with 1 to 4 channels, bilinear interpolation and constant borders only.
+// There is no image decoder: imdecode needs OpenCV (or the browser) to decode JPEG/PNG.
+
+enum ColorConversionCodes {
+  COLOR_BGR2BGRA = 0,
+  COLOR_RGB2RGBA = COLOR_BGR2BGRA,
+  COLOR_BGRA2BGR = 1,
+  COLOR_RGBA2RGB = COLOR_BGRA2BGR,
+  COLOR_BGR2RGBA = 2,
+  COLOR_RGB2BGRA = COLOR_BGR2RGBA,
+  COLOR_RGBA2BGR = 3,
+  COLOR_BGRA2RGB = COLOR_RGBA2BGR,
+  COLOR_BGR2RGB = 4,
+  COLOR_RGB2BGR = COLOR_BGR2RGB,
+  COLOR_BGRA2RGBA = 5,
+  COLOR_RGBA2BGRA = COLOR_BGRA2RGBA,
+};
+
+enum InterpolationFlags {
+  INTER_LINEAR = 1,
+  WARP_INVERSE_MAP = 16,
+};
+
+enum BorderTypes {
+  BORDER_CONSTANT = 0,
+};
+
+// 8-bit images only
+void cvtColor(const Mat& src, Mat& dst, int code);
+
+// dsize wins over fx/fy when it is not empty
+void resize(const Mat& src, Mat& dst, Size dsize, double fx = 0, double fy = 0, int interpolation = INTER_LINEAR);
+
+void copyMakeBorder(const Mat& src, Mat& dst, int top, int bottom, int left, int right,
+                    int borderType, const Scalar& value = Scalar());
+
+// M is a 2x3 double or float matrix mapping src to dst, unless flags has WARP_INVERSE_MAP
+void warpAffine(const Mat& src, Mat& dst, const Mat& M, Size dsize, int flags = INTER_LINEAR,
+                int borderMode = BORDER_CONSTANT, const Scalar& borderValue = Scalar());
+
+// angle in degrees, positive is counter-clockwise
+Mat getRotationMatrix2D(Point2f center, double angle, double scale);
+
+} // namespace lite
+} // namespace vc
+
+#endif //WASMSAMPLE_IMAGE_LITE_IMGPROC_H_
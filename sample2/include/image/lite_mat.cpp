@@ -0,0 +1,147 @@
+#include "image/lite_mat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "image/lite_simd.h"
+
+namespace vc {
+namespace lite {
+
+namespace {
+
+size_t DepthSize(int depth) {
+  switch (depth) {
+    case kDepth8U: return 1;
+    case kDepth32F: return 4;
+    case kDepth64F: return 8;
+    default:
+      assert(((void)"Unsupported depth", false));
+      return 1;
+  }
+}
+
+template<typename T>
+T Saturate(double v);
+
+template<> uint8_t Saturate<uint8_t>(double v) {
+  auto i = static_cast<int>(std::lround(v));
+  return static_cast<uint8_t>(std::min(std::max(i, 0), 255));
+}
+template<> float Saturate<float>(double v) { return static_cast<float>(v); }
+template<> double Saturate<double>(double v) { return v; }
+
+template<typename S, typename D>
+void ConvertRow(const S* src, D* dst, int n, double alpha, double beta) {
+  for (int x = 0; x < n; ++x)
+    dst[x] = Saturate<D>(src[x] * alpha + beta);
+}
+
+// Normalization of the model input, the one conversion on the per-frame path
+void ConvertRow(const uint8_t* src, float* dst, int n, double alpha, double beta) {
+  int x = 0;
+#ifdef VC_LITE_SIMD
+  const auto a = simd::Splat(static_cast<float>(alpha));
+  const auto b = simd::Splat(static_cast<float>(beta));
+  for (; x + 4 <= n; x += 4)
+    simd::Store(dst + x, simd::LoadU8(src + x) * a + b);
+#endif
+  for (; x < n; ++x)
+    dst[x] = static_cast<float>(src[x] * alpha + beta);
+}
+
+template<typename S>
+void ConvertRows(const Mat& src, Mat& dst, double alpha, double beta) {
+  auto n = src.cols * src.channels();
+  for (int y = 0; y < src.rows; ++y) {
+    const auto* s = src.ptr<S>(y);
+    switch (dst.depth()) {
+      case kDepth8U: ConvertRow(s, dst.ptr<uint8_t>(y), n, alpha, beta); break;
+      case kDepth32F: ConvertRow(s, dst.ptr<float>(y), n, alpha, beta); break;
+      case kDepth64F: ConvertRow(s, dst.ptr<double>(y), n, alpha, beta); break;
+    }
+  }
+}
+
+} // namespace
+
+Rect operator & (const Rect& a, const Rect& b) {
+  auto x0 = std::max(a.x, b.x), y0 = std::max(a.y, b.y);
+  auto x1 = std::min(a.x + a.width, b.x + b.width), y1 = std::min(a.y + a.height, b.y + b.height);
+  if (x1 <= x0 || y1 <= y0)
+    return {};
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+Mat::Mat(int rows, int cols, int type) {
+  create(rows, cols, type);
+}
+
+Mat::Mat(int rows, int cols, int type, void* data, size_t step)
+  : rows(rows), cols(cols), data(static_cast<unsigned char*>(data)), type_(type) {
+  this->step = step != 0 ? step : cols * elemSize();
+}
+
+Mat Mat::operator () (const Rect& roi) const {
+  assert(roi.x >= 0 && roi.y >= 0 && roi.x + roi.width <= cols && roi.y + roi.height <= rows);
+  Mat view = *this;
+  view.rows = roi.height;
+  view.cols = roi.width;
+  view.data = data + roi.y * step + roi.x * elemSize();
+  return view;
+}
+
+Mat Mat::zeros(Size size, int type) {
+  Mat mat(size, type);
+  std::memset(mat.data, 0, mat.step * mat.rows);
+  return mat;
+}
+
+void Mat::create(int rows_, int cols_, int type) {
+  if (data != nullptr && rows == rows_ && cols == cols_ && type_ == type)
+    return;
+
+  rows = rows_;
+  cols = cols_;
+  type_ = type;
+  step = cols * elemSize();
+  storage.reset(new unsigned char[step * rows + 1], std::default_delete<unsigned char[]>());
+  data = storage.get();
+}
+
+Mat Mat::clone() const {
+  Mat dst;
+  copyTo(dst);
+  return dst;
+}
+
+void Mat::copyTo(Mat& dst) const {
+  if (dst.data == data)
+    return;
+  dst.create(rows, cols, type_);
+  auto row_bytes = cols * elemSize();
+  for (int y = 0; y < rows; ++y)
+    std::memcpy(dst.ptr(y), ptr(y), row_bytes);
+}
+
+void Mat::convertTo(Mat& dst, int rtype, double alpha, double beta) const {
+  auto dst_type = rtype < 0 ? type_ : MakeType(TypeDepth(rtype), channels());
+
+  // Keeps the source pixels alive if dst is this image and gets reallocated
+  Mat src = *this;
+  dst.create(rows, cols, dst_type);
+  switch (src.depth()) {
+    case kDepth8U: ConvertRows<uint8_t>(src, dst, alpha, beta); break;
+    case kDepth32F: ConvertRows<float>(src, dst, alpha, beta); break;
+    case kDepth64F: ConvertRows<double>(src, dst, alpha, beta); break;
+  }
+}
+
+size_t Mat::elemSize() const {
+  return DepthSize(depth()) * channels();
+}
+
+} // namespace lite
+} // namespace vc
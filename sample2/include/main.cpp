@@ -1,28 +1,427 @@
-#include <emscripten.h>
+#include <algorithm>
 
-#include "opencv2/opencv.hpp"
 #include "blaze_face_wrapper.h"
+#include "capture/frame_stream.h"
+#include "concurrent/task_pool.h"
 #include "cutemodel/cute_model.h"
+#include "detector/async_face_detector.h"
+#include "detector/batch_face_detector.h"
+#include "detector/cascade_detector.h"
+#include "detector/tiled_face_detector.h"
+#include "profile/clock.h"
+#include "profile/memory_report.h"
+#include "profile/trace_recorder.h"
+#include "platform/emscripten_compat.h"
 
 typedef void (*face_callback) (int, int, int, int, int);
 face_callback callback = nullptr;
 vc::BlazeFaceWrapper face_wrapper;
+vc::AsyncFaceDetector* async_detector = nullptr;
+vc::BatchFaceDetector* batch_detector = nullptr;
+vc::TiledFaceDetector* tiled_detector = nullptr;
+int tiled_min_face = 0;
+vc::CascadeDetector* cascade_detector = nullptr;
+vc::FrameRecorder frame_recorder;
+bool last_face_reused = false;
+
+// Layouts shared with JS for findFacesBatch
+struct FaceImage {
+  int format;
+  int width;
+  int height;
+  char* planes[3];
+  int strides[3];
+};
+
+struct FaceBatchResult {
+  int found;
+  int left;
+  int top;
+  int right;
+  int bottom;
+  int angle_degree;
+};
+
+vc::ImageDesc makeImageDesc(int format, char* plane0, char* plane1, char* plane2,
+                            int stride0, int stride1, int stride2,
+                            int width, int height) {
+  // An unknown format gives an empty image, which the detectors reject
+  vc::ImageDesc image;
+  if (format < static_cast<int>(vc::PixelFormat::kRGBA) || format > static_cast<int>(vc::PixelFormat::kI420))
+    return image;
+  image.format = static_cast<vc::PixelFormat>(format);
+  image.width = width;
+  image.height = height;
+  char* planes[3] = {plane0, plane1, plane2};
+  int strides[3] = {stride0, stride1, stride2};
+  for (int i = 0; i < vc::PlaneCount(image.format); ++i) {
+    auto size = vc::GetPlaneSize(image.format, width, height, i);
+    image.planes[i] = reinterpret_cast<unsigned char*>(planes[i]);
+    image.strides[i] = strides[i] > 0 ? strides[i] : size.row_bytes;
+  }
+  return image;
+}
+
+// Calls the face callback, with a zero roi when no face was found
+void notifyFace(const vc::ROI& roi, vc::Angle angle) {
+  if (callback == nullptr) return;
+  auto angle_degree = static_cast<int>(angle * 180 / 3.141592);
+  if (roi.empty()) callback(0, 0, 0, 0, angle_degree);
+  else callback(roi[0], roi[1], roi[2], roi[3], angle_degree);
+}
 
 extern "C" {
   EMSCRIPTEN_KEEPALIVE
   int findFace(char* buffer, int width, int height, int prior_angle_degree) {
-    cv::Mat image_rgba(height, width, CV_8UC4, buffer);
-    cv::Mat image_rgb;
-    cv::cvtColor(image_rgba, image_rgb, cv::COLOR_RGBA2RGB);
-    
-    auto [roi, angle] = face_wrapper.Execute(image_rgb, prior_angle_degree * 3.141592 / 180);
-    if (callback != nullptr) callback(roi[0], roi[1], roi[2], roi[3], static_cast<int>(angle * 180 / 3.141592));
+    vc::ScopedTrace trace("findFace", "api");
+    auto image = vc::ImageDesc::Packed(vc::PixelFormat::kRGBA, reinterpret_cast<unsigned char*>(buffer), width, height);
+
+    if (frame_recorder.IsOpen()) frame_recorder.Record(image, vc::NowMs());
+    auto face = face_wrapper.Detect(image, prior_angle_degree * 3.141592 / 180);
+    last_face_reused = face.reused;
+    auto angle = face.angle;
+    notifyFace(face.roi, angle);
+    return static_cast<int>(angle * 180 / 3.141592);
+  }
+
+  // format: vc::PixelFormat. Unused planes may be null, a stride of 0 means tightly packed.
+  EMSCRIPTEN_KEEPALIVE
+  int findFaceWithFormat(int format, char* plane0, char* plane1, char* plane2,
+                         int stride0, int stride1, int stride2,
+                         int width, int height, int prior_angle_degree) {
+    vc::ScopedTrace trace("findFace", "api");
+    auto image = makeImageDesc(format, plane0, plane1, plane2, stride0, stride1, stride2, width, height);
+
+    if (frame_recorder.IsOpen()) frame_recorder.Record(image, vc::NowMs());
+    auto face = face_wrapper.Detect(image, prior_angle_degree * 3.141592 / 180);
+    last_face_reused = face.reused;
+    auto angle = face.angle;
+    notifyFace(face.roi, angle);
     return static_cast<int>(angle * 180 / 3.141592);
   }
   
+  // Pays the interpreter's one-time setup before the first frame. Returns the warm-up time in ms, 0
+  // if a frame already paid it.
+  EMSCRIPTEN_KEEPALIVE
+  double warmupDetector() {
+    face_wrapper.Warmup();
+    return face_wrapper.ColdStart().warmup_ms;
+  }
+
+  // Searches 0, 90, -90 and 180 degrees in one batched invoke while no face is tracked, instead of
+  // only the prior angle findFace is given
+  EMSCRIPTEN_KEEPALIVE
+  void setRotationRecovery(bool enable) {
+    face_wrapper.EnableRecovery(enable);
+  }
+
+  // While the frame stays the same around the face, findFace returns its last result without
+  // running the model. threshold is the mean luma difference that counts as a change, <= 0 for the
+  // default.
+  EMSCRIPTEN_KEEPALIVE
+  void setChangeGate(bool enable, float threshold) {
+    face_wrapper.EnableChangeGate(enable, threshold > 0 ? threshold : vc::ChangeDetector::kDefaultThreshold);
+  }
+
+  // Holds findFace under target_ms per frame (mean) by adjusting threads, rotation recovery and
+  // how often the model runs, up to max_threads (0 for the current count). 0 ms turns it off.
+  EMSCRIPTEN_KEEPALIVE
+  void setLatencyTarget(double target_ms, int max_threads) {
+    vc::QosOptions options;
+    options.target_ms = target_ms;
+    options.max_threads = max_threads;
+    face_wrapper.SetQos(options);
+  }
+
+  // JSON of the operating point setLatencyTarget chose: threads, interval, recovery, mean_ms
+  EMSCRIPTEN_KEEPALIVE
+  const char* getQosStatus() {
+    static std::string json;
+    json = face_wrapper.QosStatus().ToJson();
+    return json.c_str();
+  }
+
+  // Whether the last findFace result was reused by the change gate or the QoS interval
+  EMSCRIPTEN_KEEPALIVE
+  bool wasLastFaceReused() {
+    return last_face_reused;
+  }
+
   EMSCRIPTEN_KEEPALIVE
   bool setFaceCallback(face_callback callback_) {
     callback = callback_;
     return true;
   }
-}
\ No newline at end of file
+
+  //
+  // Off-main-thread detection
+  //
+  EMSCRIPTEN_KEEPALIVE
+  bool startFaceDetector() {
+    if (async_detector == nullptr) async_detector = new vc::AsyncFaceDetector();
+    async_detector->Start();
+    return true;
+  }
+
+  EMSCRIPTEN_KEEPALIVE
+  void stopFaceDetector() {
+    if (async_detector != nullptr) async_detector->Stop();
+  }
+
+  EMSCRIPTEN_KEEPALIVE
+  int submitFrame(char* buffer, int width, int height) {
+    if (async_detector == nullptr) return 0;
+    return static_cast<int>(async_detector->Submit(reinterpret_cast<unsigned char*>(buffer), width, height));
+  }
+
+  EMSCRIPTEN_KEEPALIVE
+  int submitFrameWithFormat(int format, char* plane0, char* plane1, char* plane2,
+                            int stride0, int stride1, int stride2,
+                            int width, int height) {
+    if (async_detector == nullptr) return 0;
+    auto image = makeImageDesc(format, plane0, plane1, plane2, stride0, stride1, stride2, width, height);
+    return static_cast<int>(async_detector->Submit(image));
+  }
+
+  // out: left, top, right, bottom, angle(degree), frame id
+  EMSCRIPTEN_KEEPALIVE
+  bool pollFaceResult(int* out) {
+    vc::FaceResult result;
+    if (async_detector == nullptr || !async_detector->Poll(result)) return false;
+    for (int i = 0; i < 4; ++i) out[i] = result.found ? result.roi[i] : 0;
+    out[4] = static_cast<int>(result.angle * 180 / 3.141592);
+    out[5] = static_cast<int>(result.frame_id);
+    return true;
+  }
+
+  //
+  // Cascade: BlazeFace, then a landmark model on the face crop
+  //
+
+  // model is copied. score_output is the index of the model's confidence output, -1 if it has none.
+  // While the landmark model scores at least track_score the detector is skipped.
+  EMSCRIPTEN_KEEPALIVE
+  bool initCascade(char* model, int model_size, int landmark_stride, int score_output, float track_score) {
+    vc::CascadeStageOptions options;
+    options.model_buffer = model;
+    options.model_size = static_cast<size_t>(model_size);
+    options.landmark_stride = landmark_stride;
+    options.score_output = score_output;
+    delete cascade_detector;
+    cascade_detector = new vc::CascadeDetector(options, track_score);
+    return true;
+  }
+
+  // Writes up to max_points (x, y) pairs to points and returns the landmark count, 0 without a face
+  EMSCRIPTEN_KEEPALIVE
+  int findFaceCascade(char* buffer, int width, int height, float* points, int max_points) {
+    if (cascade_detector == nullptr) return 0;
+    vc::ScopedTrace trace("findFaceCascade", "api");
+    auto image = vc::ImageDesc::Packed(vc::PixelFormat::kRGBA, reinterpret_cast<unsigned char*>(buffer), width, height);
+
+    auto result = cascade_detector->Detect(image);
+    if (!result.found) return 0;
+    const auto& landmarks = result.stage.landmarks;
+    auto count = std::min(static_cast<int>(landmarks.size()), max_points);
+    for (int i = 0; i < count; ++i) {
+      points[2 * i] = landmarks[i].x;
+      points[2 * i + 1] = landmarks[i].y;
+    }
+    return static_cast<int>(landmarks.size());
+  }
+
+  //
+  // Offline batch detection
+  //
+
+  // Runs count images across the pthread pool. results must hold count entries.
+  // Blocks the calling thread, so prefer calling it off the browser main thread.
+  EMSCRIPTEN_KEEPALIVE
+  int findFacesBatch(const FaceImage* images, int count, FaceBatchResult* results) {
+    if (batch_detector == nullptr) batch_detector = new vc::BatchFaceDetector(vc::TaskPool::Instance().NumWorkers() + 1);
+
+    std::vector<vc::ImageDesc> descs;
+    descs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      const auto& image = images[i];
+      descs.push_back(makeImageDesc(image.format, image.planes[0], image.planes[1], image.planes[2],
+                                    image.strides[0], image.strides[1], image.strides[2],
+                                    image.width, image.height));
+    }
+
+    std::vector<vc::FaceResult> faces(count);
+    batch_detector->Detect(descs.data(), count, faces.data());
+
+    int found = 0;
+    for (int i = 0; i < count; ++i) {
+      const auto& face = faces[i];
+      auto& result = results[i];
+      result.found = face.found;
+      result.left = face.found ? face.roi[0] : 0;
+      result.top = face.found ? face.roi[1] : 0;
+      result.right = face.found ? face.roi[2] : 0;
+      result.bottom = face.found ? face.roi[3] : 0;
+      result.angle_degree = static_cast<int>(face.angle * 180 / 3.141592);
+      found += face.found;
+    }
+    return found;
+  }
+
+  // Every face of a large image down to min_face pixels, see TiledFaceDetector. Writes up to
+  // max_faces entries (found is always 1) and returns the number of faces.
+  // Blocks the calling thread, so prefer calling it off the browser main thread.
+  EMSCRIPTEN_KEEPALIVE
+  int findFacesTiled(int format, char* plane0, char* plane1, char* plane2,
+                     int stride0, int stride1, int stride2,
+                     int width, int height, int min_face, FaceBatchResult* results, int max_faces) {
+    if (tiled_detector == nullptr || tiled_min_face != min_face) {
+      vc::TileOptions options;
+      options.min_face = min_face;
+      delete tiled_detector;
+      tiled_detector = new vc::TiledFaceDetector(options, vc::TaskPool::Instance().NumWorkers() + 1);
+      tiled_min_face = min_face;
+    }
+
+    auto image = makeImageDesc(format, plane0, plane1, plane2, stride0, stride1, stride2, width, height);
+    auto faces = tiled_detector->Detect(image);
+    auto count = std::min(static_cast<int>(faces.size()), max_faces);
+    for (int i = 0; i < count; ++i) {
+      const auto& face = faces[i];
+      auto& result = results[i];
+      result.found = 1;
+      result.left = face.roi[0];
+      result.top = face.roi[1];
+      result.right = face.roi[2];
+      result.bottom = face.roi[3];
+      result.angle_degree = static_cast<int>(face.angle * 180 / 3.141592);
+    }
+    return static_cast<int>(faces.size());
+  }
+
+  EMSCRIPTEN_KEEPALIVE
+  int getDroppedFrameCount() {
+    if (async_detector == nullptr) return 0;
+    return static_cast<int>(async_detector->GetStats().dropped);
+  }
+
+  //
+  // Thread calibration
+  //
+
+  // Times invokes at 1..N threads (N capped by max_threads if > 0), applies the fastest stable
+  // count to the main-thread detector and returns the result as JSON. Takes a few hundred
+  // milliseconds unless the choice is already cached.
+  EMSCRIPTEN_KEEPALIVE
+  const char* calibrateThreads(int max_threads) {
+    static std::string json;
+    vc::ThreadTuneOptions options;
+    options.max_threads = max_threads;
+    auto tuning = vc::BlazeFaceWrapper::TuneThreads(options);
+    face_wrapper.SetNumThreads(tuning.num_threads);
+    json = tuning.ToJson();
+    return json.c_str();
+  }
+
+  // "signature=threads" lines, persist them to skip calibration on the next load
+  EMSCRIPTEN_KEEPALIVE
+  const char* getThreadTuningCache() {
+    static std::string cache;
+    cache = vc::ThreadTuner::SaveCache();
+    return cache.c_str();
+  }
+
+  EMSCRIPTEN_KEEPALIVE
+  void setThreadTuningCache(const char* cache) {
+    vc::ThreadTuner::LoadCache(cache);
+  }
+
+  //
+  // Instrumentation
+  //
+
+  // JSON snapshot of frame counts, last frame timings and per-stage latency histograms.
+  // async selects the off-main-thread detector, reset clears the counters after the snapshot.
+  EMSCRIPTEN_KEEPALIVE
+  const char* getDetectorStats(bool async, bool reset) {
+    static std::string json;
+    if (async) {
+      json = async_detector != nullptr ? async_detector->SnapshotDetectorStats(reset).ToJson() : "{}";
+    } else {
+      json = face_wrapper.SnapshotStats(reset).ToJson();
+    }
+    return json.c_str();
+  }
+
+  // Starts recording a timeline of findFace calls, wrapper stages and TFLite operators.
+  // capacity is the number of events kept, older ones are overwritten.
+  EMSCRIPTEN_KEEPALIVE
+  void enableTracing(int capacity) {
+    auto& recorder = vc::TraceRecorder::Instance();
+    recorder.SetThreadName("main");
+    recorder.Enable(capacity > 0 ? capacity : 16384);
+    face_wrapper.EnableOpTracing(true);
+  }
+
+  EMSCRIPTEN_KEEPALIVE
+  void disableTracing() {
+    face_wrapper.EnableOpTracing(false);
+    vc::TraceRecorder::Instance().Disable();
+  }
+
+  // Chrome trace-event JSON, load it in chrome://tracing or https://ui.perfetto.dev
+  EMSCRIPTEN_KEEPALIVE
+  const char* getTraceJson(bool clear) {
+    static std::string json;
+    auto& recorder = vc::TraceRecorder::Instance();
+    json = recorder.ToJson();
+    if (clear) recorder.Clear();
+    return json.c_str();
+  }
+
+  //
+  // Frame capture
+  //
+
+  // Records every frame passed to findFace / findFaceWithFormat to path (in the Emscripten file
+  // system, read it with FS.readFile) for replaying with sample1's WasmReplayBenchmark
+  EMSCRIPTEN_KEEPALIVE
+  bool startFrameCapture(const char* path) {
+    return frame_recorder.Open(path);
+  }
+
+  // Returns the number of frames recorded
+  EMSCRIPTEN_KEEPALIVE
+  int stopFrameCapture() {
+    frame_recorder.Close();
+    return frame_recorder.FrameCount();
+  }
+
+  //
+  // Memory
+  //
+
+  // Caps the heap, in bytes, that detectors and the trace buffer created from now on size their
+  // preallocated buffers for. 0 turns the budget off.
+  EMSCRIPTEN_KEEPALIVE
+  void setMemoryBudget(int bytes) {
+    vc::MemoryBudget::Instance().SetCap(bytes > 0 ? static_cast<size_t>(bytes) : 0);
+  }
+
+  // JSON breakdown of the memory held by all detectors, plus heap usage and the wasm memory size
+  EMSCRIPTEN_KEEPALIVE
+  const char* getMemoryReport() {
+    static std::string json;
+    auto report = face_wrapper.MemoryUsage();
+    auto add = [&report](const vc::MemoryReport& other) {
+      report.arena_bytes += other.arena_bytes;
+      report.persistent_arena_bytes += other.persistent_arena_bytes;
+      report.image_scratch_bytes += other.image_scratch_bytes;
+      report.frame_buffer_bytes += other.frame_buffer_bytes;
+    };
+    if (async_detector != nullptr) add(async_detector->MemoryUsage());
+    if (batch_detector != nullptr) add(batch_detector->MemoryUsage());
+    report.trace_buffer_bytes = vc::TraceRecorder::Instance().BufferBytes();
+    json = report.ToJson();
+    return json.c_str();
+  }
+}
@@ -0,0 +1,312 @@
+#include "model/model_rewriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace vc {
+
+namespace {
+
+using tflite::BuiltinOperator;
+
+BuiltinOperator OpCode(const tflite::ModelT& model, const tflite::OperatorT& op) {
+  const auto& code = *model.operator_codes[op.opcode_index];
+  // Older models only fill deprecated_builtin_code, codes past 127 only fit builtin_code
+  return std::max(code.builtin_code, static_cast<BuiltinOperator>(code.deprecated_builtin_code));
+}
+
+uint32_t OpCodeIndex(tflite::ModelT& model, BuiltinOperator builtin) {
+  for (size_t i = 0; i < model.operator_codes.size(); ++i) {
+    const auto& code = *model.operator_codes[i];
+    if (code.custom_code.empty()
+        && std::max(code.builtin_code, static_cast<BuiltinOperator>(code.deprecated_builtin_code)) == builtin)
+      return static_cast<uint32_t>(i);
+  }
+  auto code = std::make_unique<tflite::OperatorCodeT>();
+  code->builtin_code = builtin;
+  code->deprecated_builtin_code = static_cast<int8_t>(builtin);
+  code->version = 1;
+  model.operator_codes.push_back(std::move(code));
+  return static_cast<uint32_t>(model.operator_codes.size() - 1);
+}
+
+float HalfToFloat(uint16_t half) {
+  uint32_t sign = (half & 0x8000u) << 16, exponent = (half >> 10) & 0x1fu, mantissa = half & 0x3ffu;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    bits = sign | 0x7f800000u | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // Subnormal, shifted until the implicit bit is set
+    exponent = 113;
+    for (; (mantissa & 0x400u) == 0; mantissa <<= 1) --exponent;
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Values of a constant float tensor, or of the float16 constant a DEQUANTIZE expands into it
+bool ConstantValues(const tflite::ModelT& model, const tflite::SubGraphT& graph, int index,
+                    std::vector<float>& values) {
+  const auto& tensor = *graph.tensors[index];
+  const auto& data = model.buffers[tensor.buffer]->data;
+  if (!data.empty()) {
+    if (tensor.type != tflite::TensorType_FLOAT32)
+      return false;
+    values.resize(data.size() / sizeof(float));
+    std::memcpy(values.data(), data.data(), values.size() * sizeof(float));
+    return true;
+  }
+
+  for (const auto& op : graph.operators) {
+    if (std::find(op->outputs.begin(), op->outputs.end(), index) == op->outputs.end())
+      continue;
+    if (OpCode(model, *op) != tflite::BuiltinOperator_DEQUANTIZE)
+      return false;
+    const auto& source = *graph.tensors[op->inputs[0]];
+    const auto& half = model.buffers[source.buffer]->data;
+    if (source.type != tflite::TensorType_FLOAT16 || half.empty())
+      return false;
+    values.resize(half.size() / sizeof(uint16_t));
+    for (size_t i = 0; i < values.size(); ++i) {
+      uint16_t value;
+      std::memcpy(&value, half.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+      values[i] = HalfToFloat(value);
+    }
+    return true;
+  }
+  return false;
+}
+
+int AddTensor(tflite::SubGraphT& graph, const std::string& name, tflite::TensorType type, std::vector<int> shape) {
+  auto tensor = std::make_unique<tflite::TensorT>();
+  tensor->name = name;
+  tensor->type = type;
+  tensor->shape = std::move(shape);
+  graph.tensors.push_back(std::move(tensor));
+  return static_cast<int>(graph.tensors.size() - 1);
+}
+
+template<typename T>
+int AddConstant(tflite::ModelT& model, tflite::SubGraphT& graph, const std::string& name, tflite::TensorType type,
+                std::vector<int> shape, const std::vector<T>& values) {
+  auto buffer = std::make_unique<tflite::BufferT>();
+  buffer->data.resize(values.size() * sizeof(T));
+  std::memcpy(buffer->data.data(), values.data(), buffer->data.size());
+  model.buffers.push_back(std::move(buffer));
+
+  auto index = AddTensor(graph, name, type, std::move(shape));
+  graph.tensors[index]->buffer = static_cast<uint32_t>(model.buffers.size() - 1);
+  return index;
+}
+
+// Padding TFLite adds for SAME along one axis, the smaller half before
+int SamePadding(int size, int kernel, int stride, int dilation) {
+  auto out = (size + stride - 1) / stride;
+  return std::max((out - 1) * stride + (kernel - 1) * dilation + 1 - size, 0);
+}
+
+// DEQUANTIZE ops whose output nothing reads anymore
+void RemoveDeadDequantize(const tflite::ModelT& model, tflite::SubGraphT& graph) {
+  std::unordered_set<int> read(graph.outputs.begin(), graph.outputs.end());
+  for (const auto& op : graph.operators)
+    read.insert(op->inputs.begin(), op->inputs.end());
+
+  graph.operators.erase(
+      std::remove_if(graph.operators.begin(), graph.operators.end(), [&](const auto& op) {
+        return OpCode(model, *op) == tflite::BuiltinOperator_DEQUANTIZE && op->outputs.size() == 1
+            && read.count(op->outputs[0]) == 0;
+      }),
+      graph.operators.end());
+}
+
+// Drops the tensors of the main graph nothing refers to and renumbers the rest
+void RemoveUnusedTensors(tflite::ModelT& model, tflite::SubGraphT& graph) {
+  std::vector<bool> used(graph.tensors.size(), false);
+  auto mark = [&](const std::vector<int32_t>& indices) {
+    for (auto index : indices)
+      if (index >= 0) used[index] = true;
+  };
+  mark(graph.inputs);
+  mark(graph.outputs);
+  for (const auto& op : graph.operators) {
+    mark(op->inputs);
+    mark(op->outputs);
+    mark(op->intermediates);
+  }
+  for (const auto& signature : model.signature_defs) {
+    for (const auto& entry : signature->inputs) used[entry->tensor_index] = true;
+    for (const auto& entry : signature->outputs) used[entry->tensor_index] = true;
+  }
+
+  std::vector<int32_t> remap(graph.tensors.size(), -1);
+  std::vector<std::unique_ptr<tflite::TensorT>> tensors;
+  for (size_t i = 0; i < graph.tensors.size(); ++i) {
+    if (!used[i])
+      continue;
+    remap[i] = static_cast<int32_t>(tensors.size());
+    tensors.push_back(std::move(graph.tensors[i]));
+  }
+  graph.tensors = std::move(tensors);
+
+  auto apply = [&](std::vector<int32_t>& indices) {
+    for (auto& index : indices)
+      if (index >= 0) index = remap[index];
+  };
+  apply(graph.inputs);
+  apply(graph.outputs);
+  for (auto& op : graph.operators) {
+    apply(op->inputs);
+    apply(op->outputs);
+    apply(op->intermediates);
+  }
+  for (auto& signature : model.signature_defs) {
+    for (auto& entry : signature->inputs) entry->tensor_index = remap[entry->tensor_index];
+    for (auto& entry : signature->outputs) entry->tensor_index = remap[entry->tensor_index];
+  }
+}
+
+// Drops the buffers no tensor or metadata refers to. Buffer 0 stays, it is the empty buffer of
+// tensors without data.
+void RemoveUnusedBuffers(tflite::ModelT& model) {
+  if (model.buffers.empty())
+    return;
+  std::vector<bool> used(model.buffers.size(), false);
+  used[0] = true;
+  for (const auto& graph : model.subgraphs)
+    for (const auto& tensor : graph->tensors)
+      used[tensor->buffer] = true;
+  for (auto index : model.metadata_buffer)
+    used[index] = true;
+  for (const auto& metadata : model.metadata)
+    used[metadata->buffer] = true;
+
+  std::vector<uint32_t> remap(model.buffers.size(), 0);
+  std::vector<std::unique_ptr<tflite::BufferT>> buffers;
+  for (size_t i = 0; i < model.buffers.size(); ++i) {
+    if (!used[i])
+      continue;
+    remap[i] = static_cast<uint32_t>(buffers.size());
+    buffers.push_back(std::move(model.buffers[i]));
+  }
+  model.buffers = std::move(buffers);
+
+  for (auto& graph : model.subgraphs)
+    for (auto& tensor : graph->tensors)
+      tensor->buffer = remap[tensor->buffer];
+  for (auto& index : model.metadata_buffer)
+    index = static_cast<int32_t>(remap[index]);
+  for (auto& metadata : model.metadata)
+    metadata->buffer = remap[metadata->buffer];
+}
+
+} // namespace
+
+std::vector<char> FoldInputNormalization(const void* buffer, size_t size, float scale, float offset) {
+  flatbuffers::Verifier verifier(static_cast<const uint8_t*>(buffer), size);
+  if (scale == 0 || !tflite::VerifyModelBuffer(verifier))
+    return {};
+
+  auto model = tflite::UnPackModel(buffer);
+  if (model->subgraphs.empty())
+    return {};
+  auto& graph = *model->subgraphs[0];
+  if (graph.inputs.size() != 1)
+    return {};
+  const auto input = graph.inputs[0];
+  const auto input_shape = graph.tensors[input]->shape;
+  if (graph.tensors[input]->type != tflite::TensorType_FLOAT32 || input_shape.size() != 4)
+    return {};
+
+  tflite::OperatorT* conv = nullptr;
+  for (auto& op : graph.operators) {
+    if (std::find(op->inputs.begin(), op->inputs.end(), input) == op->inputs.end())
+      continue;
+    if (conv != nullptr || OpCode(*model, *op) != tflite::BuiltinOperator_CONV_2D || op->inputs[0] != input)
+      return {};
+    conv = op.get();
+  }
+  auto* options = conv != nullptr ? conv->builtin_options.AsConv2DOptions() : nullptr;
+  if (options == nullptr || conv->inputs.size() < 2)
+    return {};
+
+  // Weights are out channels, kernel height, kernel width, in channels
+  std::vector<float> weights, bias;
+  const auto weights_name = graph.tensors[conv->inputs[1]]->name;
+  const auto weights_shape = graph.tensors[conv->inputs[1]]->shape;
+  if (weights_shape.size() != 4 || weights_shape[3] != input_shape[3]
+      || !ConstantValues(*model, graph, conv->inputs[1], weights))
+    return {};
+  const auto out_channels = weights_shape[0];
+  const auto taps = static_cast<size_t>(weights_shape[1]) * weights_shape[2] * weights_shape[3];
+  if (weights.size() != taps * out_channels)
+    return {};
+  if (conv->inputs.size() > 2 && conv->inputs[2] >= 0) {
+    if (!ConstantValues(*model, graph, conv->inputs[2], bias) || bias.size() != static_cast<size_t>(out_channels))
+      return {};
+  } else {
+    bias.assign(out_channels, 0);
+  }
+
+  // w * (x * scale + offset) + b = (w * scale) * x + (b + offset * sum(w))
+  for (int o = 0; o < out_channels; ++o) {
+    double sum = 0;
+    for (size_t i = 0; i < taps; ++i) {
+      auto& w = weights[o * taps + i];
+      sum += w;
+      w *= scale;
+    }
+    bias[o] += static_cast<float>(offset * sum);
+  }
+  conv->inputs.resize(3);
+  conv->inputs[1] = AddConstant(*model, graph, weights_name + "_folded", tflite::TensorType_FLOAT32,
+                                weights_shape, weights);
+  conv->inputs[2] = AddConstant(*model, graph, weights_name + "_folded_bias", tflite::TensorType_FLOAT32,
+                                {out_channels}, bias);
+
+  // Zeros padded by the convolution would be -offset / scale in normalized pixels, so the input is
+  // padded with the raw value of a normalized zero instead
+  if (options->padding == tflite::Padding_SAME) {
+    auto pad_h = SamePadding(input_shape[1], weights_shape[1], options->stride_h, options->dilation_h_factor);
+    auto pad_w = SamePadding(input_shape[2], weights_shape[2], options->stride_w, options->dilation_w_factor);
+    if (pad_h > 0 || pad_w > 0) {
+      std::vector<int32_t> paddings{0, 0, pad_h / 2, pad_h - pad_h / 2, pad_w / 2, pad_w - pad_w / 2, 0, 0};
+      auto pad = std::make_unique<tflite::OperatorT>();
+      pad->opcode_index = OpCodeIndex(*model, tflite::BuiltinOperator_PADV2);
+      pad->inputs = {input,
+                     AddConstant(*model, graph, "input_paddings", tflite::TensorType_INT32, {4, 2}, paddings),
+                     AddConstant(*model, graph, "input_pad_value", tflite::TensorType_FLOAT32, {1},
+                                 std::vector<float>{-offset / scale})};
+      pad->outputs = {AddTensor(graph, "input_padded", tflite::TensorType_FLOAT32,
+                                {input_shape[0], input_shape[1] + pad_h, input_shape[2] + pad_w, input_shape[3]})};
+      pad->builtin_options.Set(tflite::PadV2OptionsT());
+
+      conv->inputs[0] = pad->outputs[0];
+      options->padding = tflite::Padding_VALID;
+      graph.operators.insert(graph.operators.begin(), std::move(pad));
+    }
+  }
+
+  // The float16 weights and the tensors between them and the convolution are left without readers
+  RemoveDeadDequantize(*model, graph);
+  RemoveUnusedTensors(*model, graph);
+  RemoveUnusedBuffers(*model);
+
+  flatbuffers::FlatBufferBuilder builder;
+  tflite::FinishModelBuffer(builder, tflite::Model::Pack(builder, model.get()));
+  const auto* data = reinterpret_cast<const char*>(builder.GetBufferPointer());
+  return std::vector<char>(data, data + builder.GetSize());
+}
+
+} // namespace vc
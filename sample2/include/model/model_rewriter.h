@@ -0,0 +1,27 @@
+#ifndef WASMSAMPLE_MODEL_MODEL_REWRITER_H_
+#define WASMSAMPLE_MODEL_MODEL_REWRITER_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace vc {
+
+// Copy of a .tflite model whose input is x instead of x * scale + offset.
+//
+// The normalization is folded into the first convolution, which must be the only consumer of the
+// single float input: its weights are multiplied by scale and offset times their sum is added to the
+// bias. Float16 weights behind a DEQUANTIZE are folded in float32. A convolution with SAME padding
+// becomes an explicit PADV2 with the raw value of a normalized zero, -offset / scale, followed by a
+// VALID convolution, so the outputs at the borders stay the same too. Tensors and buffers left
+// without readers are dropped.
+//
+// The arithmetic leaves the preprocessing, but with SAME padding the input is still copied once:
+// the PADV2, which the TFLite 2.5 XNNPACK delegate does not take, runs as a builtin kernel ahead of
+// the delegated part of the graph.
+//
+// Returns an empty buffer if the model does not have that shape.
+std::vector<char> FoldInputNormalization(const void* buffer, size_t size, float scale, float offset);
+
+} // namespace vc
+
+#endif //WASMSAMPLE_MODEL_MODEL_REWRITER_H_
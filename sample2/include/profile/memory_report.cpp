@@ -0,0 +1,79 @@
+#include "profile/memory_report.h"
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <sstream>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+std::atomic<size_t> peak_heap_top{0};
+
+} // namespace
+
+HeapStats HeapStats::Read() {
+  HeapStats stats;
+
+  // mallinfo() walks the heap, so it is meant for reports, not for every frame
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  auto info = mallinfo2();
+#else
+  auto info = mallinfo();
+#endif
+  // Large blocks are mmapped natively and not part of uordblks
+  stats.in_use = static_cast<size_t>(info.uordblks) + static_cast<size_t>(info.hblkhd);
+  stats.reserved = static_cast<size_t>(info.arena);
+  stats.top = reinterpret_cast<size_t>(sbrk(0));
+
+  auto peak = peak_heap_top.load(std::memory_order_relaxed);
+  while (stats.top > peak && !peak_heap_top.compare_exchange_weak(peak, stats.top)) {}
+  stats.peak_top = std::max(peak, stats.top);
+
+#ifdef __EMSCRIPTEN__
+  stats.memory_size = emscripten_get_heap_size();
+#endif
+  return stats;
+}
+
+std::string MemoryReport::ToJson() const {
+  std::stringstream out;
+  out << "{\"model_bytes\":" << model_bytes
+      << ",\"arena_bytes\":" << arena_bytes
+      << ",\"persistent_arena_bytes\":" << persistent_arena_bytes
+      << ",\"image_scratch_bytes\":" << image_scratch_bytes
+      << ",\"frame_buffer_bytes\":" << frame_buffer_bytes
+      << ",\"trace_buffer_bytes\":" << trace_buffer_bytes
+      << ",\"budget_bytes\":" << budget_bytes
+      << ",\"heap\":{\"in_use\":" << heap.in_use
+      << ",\"reserved\":" << heap.reserved
+      << ",\"top\":" << heap.top
+      << ",\"peak_top\":" << heap.peak_top
+      << ",\"memory_size\":" << heap.memory_size << "}}";
+  return out.str();
+}
+
+MemoryBudget& MemoryBudget::Instance() {
+  static MemoryBudget budget;
+  return budget;
+}
+
+size_t MemoryBudget::Remaining() const {
+  auto in_use = HeapStats::Read().in_use;
+  return cap > in_use ? cap - in_use : 0;
+}
+
+int MemoryBudget::Fit(int wanted, size_t item_bytes, int min_count) const {
+  if (!Enabled() || item_bytes == 0)
+    return wanted;
+  auto fit = static_cast<int>(std::min<size_t>(Remaining() / item_bytes, static_cast<size_t>(wanted)));
+  return std::max(fit, std::min(min_count, wanted));
+}
+
+} // namespace vc
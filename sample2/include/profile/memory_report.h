@@ -0,0 +1,63 @@
+#ifndef WASMSAMPLE_PROFILE_MEMORY_REPORT_H_
+#define WASMSAMPLE_PROFILE_MEMORY_REPORT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace vc {
+
+// Process heap as seen by malloc. On Emscripten heap_top is the sbrk break, which only grows, and
+// memory_size is the size of the wasm memory (INITIAL_MEMORY unless it has grown).
+struct HeapStats {
+  size_t in_use = 0;
+  size_t reserved = 0;
+  size_t top = 0;
+  size_t peak_top = 0;
+  size_t memory_size = 0;
+
+  static HeapStats Read();
+};
+
+// Bytes held by each component. Components are filled by their owners; fields that do not
+// apply stay 0. The embedded model lives in static data rather than on the heap, and XNNPACK's
+// packed weights are heap memory the interpreter does not expose, only visible in heap.in_use.
+struct MemoryReport {
+  size_t model_bytes = 0;
+  size_t arena_bytes = 0;
+  size_t persistent_arena_bytes = 0;
+  size_t image_scratch_bytes = 0;
+  size_t frame_buffer_bytes = 0;
+  size_t trace_buffer_bytes = 0;
+  size_t budget_bytes = 0;
+  HeapStats heap;
+
+  std::string ToJson() const;
+};
+
+// Opt-in memory cap. When a cap is set, components that preallocate (pipeline frame contexts,
+// batch workers, the trace buffer) ask Fit() how many items they may allocate instead of taking
+// their default count. Nothing is evicted when the cap is lowered later.
+class MemoryBudget {
+ public:
+  static MemoryBudget& Instance();
+
+  // 0 disables the budget
+  void SetCap(size_t bytes) { cap = bytes; }
+  size_t Cap() const { return cap; }
+  bool Enabled() const { return cap > 0; }
+
+  // Heap left under the cap, from the current heap usage
+  size_t Remaining() const;
+
+  // Number of item_bytes sized items, between min_count and wanted, that fit in Remaining().
+  // Returns wanted when the budget is disabled.
+  int Fit(int wanted, size_t item_bytes, int min_count = 1) const;
+
+ private:
+  std::atomic<size_t> cap{0};
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_MEMORY_REPORT_H_
@@ -0,0 +1,100 @@
+#include "profile/qos_controller.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace vc {
+
+namespace {
+
+// Retry time doubles up to 2^kMaxBackoff times for a point that keeps failing right after a retry
+constexpr int kMaxBackoff = 3;
+
+} // namespace
+
+std::string QosReport::ToJson() const {
+  std::stringstream out;
+  out << "{\"enabled\":" << (enabled ? "true" : "false")
+      << ",\"num_threads\":" << point.num_threads
+      << ",\"interval\":" << point.interval
+      << ",\"recovery\":" << (point.recovery ? "true" : "false")
+      << ",\"level\":" << level
+      << ",\"levels\":" << levels
+      << ",\"target_ms\":" << target_ms
+      << ",\"mean_ms\":" << mean_ms
+      << ",\"frames\":" << frames
+      << ",\"steps_down\":" << steps_down
+      << ",\"steps_up\":" << steps_up << "}";
+  return out.str();
+}
+
+QosController::QosController(const QosOptions& options, int num_threads, bool recovery)
+  : options(options) {
+  auto min_threads = std::max(this->options.min_threads, 1);
+  auto max_threads = std::max(this->options.max_threads > 0 ? this->options.max_threads : num_threads, min_threads);
+  this->options.window = std::max(this->options.window, 1);
+
+  for (int threads = min_threads; threads <= max_threads; ++threads)
+    ladder.push_back({threads, 1, true});
+  if (recovery)
+    ladder.push_back({max_threads, 1, false});
+  for (int interval = 2; interval <= this->options.max_interval; ++interval)
+    ladder.push_back({max_threads, interval, !recovery});
+
+  retry_at.assign(ladder.size(), 0);
+  failures.assign(ladder.size(), 0);
+  level = std::clamp(num_threads, min_threads, max_threads) - min_threads;
+}
+
+bool QosController::Update(double frame_ms) {
+  ++frames;
+  if (settle > 0) {
+    --settle;
+    return false;
+  }
+
+  window_sum += frame_ms;
+  if (++window_frames < options.window)
+    return false;
+
+  last_mean = window_sum / window_frames;
+  window_sum = 0;
+  window_frames = 0;
+
+  auto previous = level;
+  if (last_mean > options.target_ms && level + 1 < static_cast<int>(ladder.size())) {
+    // A point that fails right after a retry waits longer for the next one
+    auto quick_failure = entered_from_above && frames - entered_at <= 2 * static_cast<uint64_t>(options.window);
+    failures[level] = quick_failure ? std::min(failures[level] + 1, kMaxBackoff) : 0;
+    retry_at[level] = frames + (static_cast<uint64_t>(options.retry_frames) << failures[level]);
+    ++level;
+    ++steps_down;
+    entered_from_above = false;
+  } else if (last_mean < options.target_ms * (1 - options.hysteresis) && level > 0 && frames >= retry_at[level - 1]) {
+    --level;
+    ++steps_up;
+    entered_from_above = true;
+  }
+
+  if (level == previous)
+    return false;
+  entered_at = frames;
+  settle = kSettleFrames;
+  return true;
+}
+
+QosReport QosController::Report() const {
+  QosReport report;
+  report.enabled = true;
+  report.point = Point();
+  report.level = level;
+  report.levels = static_cast<int>(ladder.size());
+  report.target_ms = options.target_ms;
+  report.mean_ms = last_mean;
+  report.frames = frames;
+  report.steps_down = steps_down;
+  report.steps_up = steps_up;
+  return report;
+}
+
+} // namespace vc
@@ -0,0 +1,87 @@
+#ifndef WASMSAMPLE_PROFILE_QOS_CONTROLLER_H_
+#define WASMSAMPLE_PROFILE_QOS_CONTROLLER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vc {
+
+struct QosOptions {
+  double target_ms = 0;     // mean time per frame to stay under, 0 for off
+  int min_threads = 1;
+  int max_threads = 0;      // 0 for the thread count the detector has when the controller starts
+  int max_interval = 4;     // at the cheapest point only every max_interval-th frame runs the model
+  double hysteresis = 0.2;  // steps back to a costlier point below (1 - hysteresis) * target_ms
+  int window = 30;          // frames averaged per decision
+  int retry_frames = 300;   // a point left for being too slow is retried after this, doubling per failure
+};
+
+// Knobs of the detector the controller sets
+struct QosPoint {
+  int num_threads = 1;
+  int interval = 1;       // the model runs on every interval-th frame, the others reuse its result
+  bool recovery = true;   // rotation recovery while the face is lost, if the detector has it enabled
+
+  bool operator == (const QosPoint& other) const {
+    return num_threads == other.num_threads && interval == other.interval && recovery == other.recovery;
+  }
+  bool operator != (const QosPoint& other) const { return !(*this == other); }
+};
+
+struct QosReport {
+  bool enabled = false;
+  QosPoint point;
+  int level = 0;
+  int levels = 0;
+  double target_ms = 0;
+  double mean_ms = 0;       // of the last full window
+  uint64_t frames = 0;
+  uint64_t steps_down = 0;  // to a cheaper point
+  uint64_t steps_up = 0;
+
+  std::string ToJson() const;
+};
+
+// Holds the mean time per frame under a target by stepping along a ladder of operating points.
+//
+// The ladder starts with the fewest threads and full quality. Each step costs more CPU or gives up
+// quality for latency: one more thread up to max_threads, then no rotation recovery, then running
+// the model on every 2nd, 3rd, ... frame. A window over the target steps down right away. Stepping
+// back up waits for a window under (1 - hysteresis) * target, and for the retry time of that point
+// if it was too slow before. The first frames after a change are not measured, since a new thread
+// count rebuilds the interpreter.
+class QosController {
+ public:
+  // Starts at num_threads with full quality; recovery tells whether the ladder has a recovery step
+  QosController(const QosOptions& options, int num_threads, bool recovery);
+
+  // Time of one frame, including frames that reused a result. True if the point changed.
+  bool Update(double frame_ms);
+
+  const QosPoint& Point() const { return ladder[level]; }
+  QosReport Report() const;
+
+ private:
+  static constexpr int kSettleFrames = 2;
+
+  QosOptions options;
+  std::vector<QosPoint> ladder;
+  std::vector<uint64_t> retry_at;   // frame from which a point may be tried again
+  std::vector<int> failures;
+  int level = 0;
+  uint64_t entered_at = 0;
+  bool entered_from_above = false;
+
+  uint64_t frames = 0;
+  int settle = 0;
+  int window_frames = 0;
+  double window_sum = 0;
+  double last_mean = 0;
+  uint64_t steps_down = 0;
+  uint64_t steps_up = 0;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_QOS_CONTROLLER_H_
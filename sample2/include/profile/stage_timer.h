@@ -0,0 +1,78 @@
+#ifndef WASMSAMPLE_PROFILE_STAGE_TIMER_H_
+#define WASMSAMPLE_PROFILE_STAGE_TIMER_H_
+
+#include <array>
+
+#include "profile/clock.h"
+#include "profile/trace_recorder.h"
+
+namespace vc {
+
+enum class Stage : int {
+  kColorConvert = 0,
+  kResize,
+  kAlign,
+  kNormalize,
+  kSample,       // fused resize + align + color conversion + normalize
+  kInvoke,
+  kPostProcess,
+  kChangeGate,   // frame difference against the last inferred frame
+  kCount,
+};
+
+constexpr int kStageCount = static_cast<int>(Stage::kCount);
+
+inline const char* StageName(Stage stage) {
+  switch (stage) {
+    case Stage::kColorConvert: return "color_convert";
+    case Stage::kResize: return "resize";
+    case Stage::kAlign: return "align";
+    case Stage::kNormalize: return "normalize";
+    case Stage::kSample: return "sample";
+    case Stage::kInvoke: return "invoke";
+    case Stage::kPostProcess: return "post_process";
+    case Stage::kChangeGate: return "change_gate";
+    default: return "unknown";
+  }
+}
+
+// Milliseconds spent in each stage of one frame. Stages that did not run are 0.
+struct StageTimes {
+  std::array<double, kStageCount> ms{};
+
+  double& operator[](Stage stage) { return ms[static_cast<int>(stage)]; }
+  double operator[](Stage stage) const { return ms[static_cast<int>(stage)]; }
+
+  void clear() { ms.fill(0); }
+
+  double total() const {
+    double sum = 0;
+    for (auto t : ms) sum += t;
+    return sum;
+  }
+};
+
+// Adds the lifetime of the scope to times[stage], and to the trace if tracing is enabled
+class ScopedStage {
+ public:
+  ScopedStage(StageTimes& times, Stage stage)
+    : times(times), stage(stage), start(NowMs()) {}
+
+  ~ScopedStage() {
+    auto end = NowMs();
+    times[stage] += end - start;
+    TraceRecorder::Instance().Record(StageName(stage), "stage", start, end);
+  }
+
+  ScopedStage(const ScopedStage&) = delete;
+  ScopedStage& operator = (const ScopedStage&) = delete;
+
+ private:
+  StageTimes& times;
+  Stage stage;
+  double start;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_STAGE_TIMER_H_
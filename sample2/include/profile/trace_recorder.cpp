@@ -0,0 +1,105 @@
+#include "profile/trace_recorder.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "profile/memory_report.h"
+
+namespace vc {
+
+TraceRecorder& TraceRecorder::Instance() {
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+uint32_t TraceRecorder::ThreadId() {
+  static std::atomic<uint32_t> next_id{1};
+  thread_local uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+void TraceRecorder::Enable(size_t capacity_) {
+  // The buffer is never reallocated, so threads that are recording never see it move
+  if (events == nullptr) {
+    auto wanted = static_cast<int>(std::min<size_t>(std::max<size_t>(capacity_, 1), INT32_MAX));
+    capacity = MemoryBudget::Instance().Fit(wanted, sizeof(Event), 256);
+    events.reset(new Event[capacity]);
+  }
+  enabled.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::Disable() {
+  enabled.store(false, std::memory_order_release);
+}
+
+void TraceRecorder::Clear() {
+  for (size_t i = 0; i < capacity; ++i)
+    events[i].sequence.store(0, std::memory_order_relaxed);
+  next.store(0, std::memory_order_release);
+}
+
+void TraceRecorder::Record(const char* name, const char* category, double start_ms, double end_ms) {
+  if (!IsEnabled())
+    return;
+
+  auto index = next.fetch_add(1, std::memory_order_relaxed);
+  auto& event = events[index % capacity];
+
+  event.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.name = name;
+  event.category = category;
+  event.start_ms = start_ms;
+  event.end_ms = end_ms;
+  event.thread_id = ThreadId();
+  event.sequence.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::SetThreadName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(thread_names_mutex);
+  thread_names[ThreadId()] = name;
+}
+
+std::string TraceRecorder::ToJson() {
+  std::vector<const Event*> written;
+  for (size_t i = 0; i < capacity; ++i) {
+    if (events[i].sequence.load(std::memory_order_acquire) != 0)
+      written.push_back(&events[i]);
+  }
+  std::sort(written.begin(), written.end(), [](const Event* a, const Event* b) {
+    return a->sequence.load(std::memory_order_relaxed) < b->sequence.load(std::memory_order_relaxed);
+  });
+
+  std::stringstream out;
+  out.precision(3);
+  out << std::fixed;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  bool first = true;
+  {
+    std::lock_guard<std::mutex> lock(thread_names_mutex);
+    for (const auto& [thread_id, name] : thread_names) {
+      out << (first ? "" : ",")
+          << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread_id
+          << ",\"args\":{\"name\":\"" << name << "\"}}";
+      first = false;
+    }
+  }
+
+  // Chrome expects microseconds
+  for (const auto* event : written) {
+    out << (first ? "" : ",")
+        << "{\"ph\":\"X\",\"name\":\"" << event->name
+        << "\",\"cat\":\"" << event->category
+        << "\",\"pid\":1,\"tid\":" << event->thread_id
+        << ",\"ts\":" << event->start_ms * 1000
+        << ",\"dur\":" << (event->end_ms - event->start_ms) * 1000 << "}";
+    first = false;
+  }
+  out << "]}";
+
+  return out.str();
+}
+
+} // namespace vc
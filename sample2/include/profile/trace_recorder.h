@@ -0,0 +1,93 @@
+#ifndef WASMSAMPLE_PROFILE_TRACE_RECORDER_H_
+#define WASMSAMPLE_PROFILE_TRACE_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "profile/clock.h"
+
+namespace vc {
+
+// Optional timeline of the frame pipeline, exported as Chrome trace-event JSON
+// (chrome://tracing, https://ui.perfetto.dev).
+//
+// Events go to a ring buffer allocated once by Enable(); when it is full the oldest events are
+// overwritten. Recording is lock-free and costs a single relaxed load while tracing is disabled.
+// Names and categories must be string literals (or otherwise outlive the recorder).
+class TraceRecorder {
+ public:
+  static TraceRecorder& Instance();
+
+  // The capacity is reduced to fit the MemoryBudget when one is set
+  void Enable(size_t capacity = 16384);
+  void Disable();
+  // Acquire pairs with the release in Enable(), so a recording thread sees events and capacity
+  bool IsEnabled() const {
+    return enabled.load(std::memory_order_acquire);
+  }
+
+  void Clear();
+
+  // Complete event ('X') from start_ms to end_ms on the calling thread
+  void Record(const char* name, const char* category, double start_ms, double end_ms);
+
+  // Shown as the name of the calling thread's track
+  void SetThreadName(const std::string& name);
+
+  // Call while the traced threads are idle, events written during the dump may be skipped.
+  std::string ToJson();
+
+  size_t BufferBytes() const { return capacity * sizeof(Event); }
+
+  // Small sequential id of the calling thread
+  static uint32_t ThreadId();
+
+ private:
+  struct Event {
+    std::atomic<uint64_t> sequence{0};  // index + 1 once written, 0 while being written
+    const char* name = nullptr;
+    const char* category = nullptr;
+    double start_ms = 0;
+    double end_ms = 0;
+    uint32_t thread_id = 0;
+  };
+
+  TraceRecorder() = default;
+
+  std::atomic<bool> enabled{false};
+  std::unique_ptr<Event[]> events;
+  size_t capacity = 0;
+  std::atomic<uint64_t> next{0};
+
+  std::mutex thread_names_mutex;
+  std::map<uint32_t, std::string> thread_names;
+};
+
+// Records the lifetime of the scope if tracing is enabled
+class ScopedTrace {
+ public:
+  ScopedTrace(const char* name, const char* category)
+    : name(name), category(category),
+      start(TraceRecorder::Instance().IsEnabled() ? NowMs() : -1) {}
+
+  ~ScopedTrace() {
+    if (start >= 0)
+      TraceRecorder::Instance().Record(name, category, start, NowMs());
+  }
+
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator = (const ScopedTrace&) = delete;
+
+ private:
+  const char* name;
+  const char* category;
+  double start;
+};
+
+} // namespace vc
+
+#endif //WASMSAMPLE_PROFILE_TRACE_RECORDER_H_